@@ -0,0 +1,107 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for config-file expansion and timing statistics shared by the batch front ends
+ * */
+
+#ifndef ECE_COMMANDLINE_H
+#define ECE_COMMANDLINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Collects the command line arguments, replacing every "-config <file>" by the contents of the file.
+ *
+ * Each non-empty line of a config file holds one option without the leading dash followed by
+ * its values, e.g. "grid 100 100". Everything after a '#' is a comment. Options given on the
+ * command line after -config override the ones in the file, because later options win.
+ *
+ * @param argc argument count of main
+ * @param argv argument vector of main
+ * @param args the expanded arguments, without the program name
+ * @param error the name of the file that could not be read, if any
+ * @return true if every config file could be read
+ */
+inline bool expandConfigFiles(int argc, char *argv[], std::vector<std::string> &args, std::string &error)
+{
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (std::string(argv[arg]) != "-config" || arg + 1 >= argc)
+        {
+            args.emplace_back(argv[arg]);
+            continue;
+        }
+        std::ifstream file(argv[++arg]);
+        if (!file)
+        {
+            error = argv[arg];
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream tokens(line.substr(0, line.find('#')));
+            std::string token;
+            if (tokens >> token)
+            {
+                args.push_back(token[0] == '-' ? token : "-" + token);
+                while (tokens >> token)
+                {
+                    args.push_back(token);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Summary of repeated timing samples.
+ */
+struct SampleSummary
+{
+    double mean = 0;   // arithmetic mean of the samples
+    double stddev = 0; // sample standard deviation, 0 for a single sample
+    double min = 0;    // fastest sample
+    double max = 0;    // slowest sample
+};
+
+/**
+ * @brief Computes mean, standard deviation and range of the samples.
+ *
+ * @param samples the samples, at least one
+ * @return the summary
+ */
+inline SampleSummary summarizeSamples(const std::vector<double> &samples)
+{
+    SampleSummary summary;
+    if (samples.empty())
+    {
+        return summary;
+    }
+    summary.min = *std::min_element(samples.begin(), samples.end());
+    summary.max = *std::max_element(samples.begin(), samples.end());
+    for (double sample: samples)
+    {
+        summary.mean += sample;
+    }
+    summary.mean /= samples.size();
+    if (samples.size() > 1)
+    {
+        for (double sample: samples)
+        {
+            summary.stddev += (sample - summary.mean) * (sample - summary.mean);
+        }
+        summary.stddev = std::sqrt(summary.stddev / (samples.size() - 1));
+    }
+    return summary;
+}
+
+
+#endif //ECE_COMMANDLINE_H
@@ -0,0 +1,255 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for per-thread hardware performance counters read with perf_event_open
+ * */
+
+#ifndef ECE_PERFCOUNTERS_H
+#define ECE_PERFCOUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+const double FLOPS_PER_INTERACTION = 20; // the usual n-body convention: 3 sub, 3 fma, sqrt, div and 3 fma
+
+/**
+ * @brief The counters of one thread over one compute region.
+ *
+ * Every counter that could not be opened stays at -1, e.g. all hardware counters inside a
+ * virtual machine without a PMU or with kernel.perf_event_paranoid > 2.
+ */
+struct PerfSample
+{
+    double taskSeconds = -1;          // CPU time of the thread, a software counter
+    double cycles = -1;               // core cycles in user space
+    double instructions = -1;         // retired instructions in user space
+    double cacheMisses = -1;          // last level cache misses
+    double packedInstructions = -1;   // retired packed (SIMD) floating point instructions, Intel only
+    double scalarInstructions = -1;   // retired scalar floating point instructions, Intel only
+};
+
+/**
+ * @brief The performance counters of the calling thread.
+ *
+ * Each event is opened on its own, so the ones the machine supports still count when others
+ * are missing. Values are scaled by the enabled to running time in case the kernel multiplexes them.
+ */
+class ECE_PerfCounters
+{
+protected:
+    enum Event { TaskClock, Cycles, Instructions, CacheMisses, PackedFp, ScalarFp, EventCount };
+
+    int fds[EventCount];
+
+    static int open(std::uint32_t type, std::uint64_t config)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; // allowed up to perf_event_paranoid = 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static bool isIntel()
+    {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 9, "vendor_id") == 0)
+            {
+                return line.find("GenuineIntel") != std::string::npos;
+            }
+        }
+        return false;
+    }
+
+    double read(int event) const
+    {
+        std::uint64_t values[3]; // value, time enabled, time running
+        if (fds[event] < 0 || ::read(fds[event], values, sizeof(values)) != sizeof(values))
+        {
+            return -1;
+        }
+        return values[2] > 0 ? static_cast<double>(values[0]) * values[1] / values[2] : 0;
+    }
+public:
+    ECE_PerfCounters()
+    {
+        fds[TaskClock] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+        fds[Cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[Instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[CacheMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        // FP_ARITH_INST_RETIRED: event 0xC7, umask 0xFC counts the 128, 256 and 512-bit packed forms, 0x03 scalar
+        bool intel = fds[Cycles] >= 0 && isIntel();
+        fds[PackedFp] = intel ? open(PERF_TYPE_RAW, 0xFCC7) : -1;
+        fds[ScalarFp] = intel ? open(PERF_TYPE_RAW, 0x03C7) : -1;
+    }
+
+    ~ECE_PerfCounters()
+    {
+        for (int fd: fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    ECE_PerfCounters(const ECE_PerfCounters &) = delete;
+    ECE_PerfCounters &operator=(const ECE_PerfCounters &) = delete;
+
+    /**
+     * @brief Getter for the counters of the calling thread, opened on first use and kept for its lifetime.
+     *
+     * @return the counters
+     */
+    static ECE_PerfCounters &thisThread()
+    {
+        thread_local ECE_PerfCounters counters;
+        return counters;
+    }
+
+    /**
+     * @brief Checks if any counter could be opened.
+     *
+     * @return false if perf_event_open is not permitted or not supported
+     */
+    bool available() const
+    {
+        return fds[TaskClock] >= 0;
+    }
+
+    /**
+     * @brief Resets and starts every counter.
+     */
+    void start()
+    {
+        for (int fd: fds)
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    /**
+     * @brief Stops every counter and reads them.
+     *
+     * @return the counts since start
+     */
+    PerfSample stop()
+    {
+        for (int fd: fds)
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        PerfSample sample;
+        double taskNanoseconds = read(TaskClock);
+        sample.taskSeconds = taskNanoseconds < 0 ? -1 : taskNanoseconds * 1e-9;
+        sample.cycles = read(Cycles);
+        sample.instructions = read(Instructions);
+        sample.cacheMisses = read(CacheMisses);
+        sample.packedInstructions = read(PackedFp);
+        sample.scalarInstructions = read(ScalarFp);
+        return sample;
+    }
+};
+
+/**
+ * @brief Prints the counters of every thread and the derived throughput of a compute region.
+ *
+ * Interactions per cycle divide by the cycles of all threads together. GFLOP/s counts
+ * FLOPS_PER_INTERACTION per interaction over the wall time, like most n-body codes report it.
+ * Many cache misses per thousand instructions and a low IPC point to a memory-bound run,
+ * a high IPC with mostly packed instructions to a compute-bound one.
+ *
+ * @param out the stream to print to
+ * @param samples one entry per thread
+ * @param interactions charge-target pairs evaluated in the region
+ * @param seconds wall time of the region
+ */
+inline void printPerfReport(std::ostream &out, const std::vector<PerfSample> &samples, double interactions,
+                           double seconds)
+{
+    auto field = [&out](double value, int width, int precision) {
+        if (value < 0)
+        {
+            out << std::setw(width) << "n/a";
+        }
+        else
+        {
+            out << std::setw(width) << std::setprecision(precision) << value;
+        }
+    };
+    out << "Thread   CPU (ms)       Cycles Instructions    IPC  LLC misses   MPKI  Packed FP  Scalar FP" << std::endl;
+    PerfSample total{0, 0, 0, 0, 0, 0};
+    for (std::size_t t = 0; t < samples.size(); t++)
+    {
+        const PerfSample &s = samples[t];
+        bool hardware = s.cycles >= 0 && s.instructions >= 0;
+        out << std::setw(6) << t << std::fixed;
+        field(s.taskSeconds < 0 ? -1 : s.taskSeconds * 1000, 11, 3);
+        out << std::scientific;
+        field(s.cycles, 13, 3);
+        field(s.instructions, 13, 3);
+        out << std::fixed;
+        field(hardware && s.cycles > 0 ? s.instructions / s.cycles : -1, 7, 2);
+        out << std::scientific;
+        field(s.cacheMisses, 12, 3);
+        out << std::fixed;
+        field(s.cacheMisses >= 0 && s.instructions > 0 ? 1000 * s.cacheMisses / s.instructions : -1, 7, 2);
+        out << std::scientific;
+        field(s.packedInstructions, 11, 3);
+        field(s.scalarInstructions, 11, 3);
+        out << std::endl;
+        double *sums[] = {&total.taskSeconds, &total.cycles, &total.instructions, &total.cacheMisses,
+                          &total.packedInstructions, &total.scalarInstructions};
+        const double *values[] = {&s.taskSeconds, &s.cycles, &s.instructions, &s.cacheMisses,
+                                  &s.packedInstructions, &s.scalarInstructions};
+        for (int counter = 0; counter < 6; counter++)
+        {
+            // a counter missing on any thread is missing from the total
+            *sums[counter] = *sums[counter] < 0 || *values[counter] < 0 ? -1 : *sums[counter] + *values[counter];
+        }
+    }
+    out << std::scientific << std::setprecision(3) << "Interactions/cycle: ";
+    field(total.cycles > 0 ? interactions / total.cycles : -1, 0, 3);
+    out << ", GFLOP/s: " << std::fixed << std::setprecision(2)
+        << (seconds > 0 ? interactions * FLOPS_PER_INTERACTION / seconds * 1e-9 : 0);
+    if (total.packedInstructions >= 0 && total.packedInstructions + total.scalarInstructions > 0)
+    {
+        out << ", packed FP share: " << std::setprecision(1)
+            << 100 * total.packedInstructions / (total.packedInstructions + total.scalarInstructions) << "%";
+    }
+    out << std::endl;
+    out.unsetf(std::ios::floatfield);
+    if (!samples.empty() && samples[0].cycles < 0)
+    {
+        out << "Hardware counters unavailable: no PMU exposed or /proc/sys/kernel/perf_event_paranoid > 2" << std::endl;
+    }
+}
+
+
+#endif //ECE_PERFCOUNTERS_H
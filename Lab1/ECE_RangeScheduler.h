@@ -0,0 +1,248 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the work-stealing range scheduler shared by the std::thread and OpenMP front ends
+ * */
+
+#ifndef ECE_RANGESCHEDULER_H
+#define ECE_RANGESCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief What one worker did during a scheduled loop.
+ */
+struct WorkerStats
+{
+    double busySeconds = 0;  // time spent inside the loop body
+    double totalSeconds = 0; // time from entering run() to leaving it
+    std::size_t items = 0;   // number of indices processed
+    std::size_t chunks = 0;  // number of body calls
+    std::size_t steals = 0;  // number of ranges taken from other workers
+};
+
+/**
+ * @brief A work-stealing scheduler for an index range.
+ *
+ * Every worker starts with an equal contiguous block. A worker splits its current
+ * range in half until it is no larger than the grain, keeping the lower half and
+ * pushing the upper half onto its own deque. An idle worker steals the oldest, and
+ * therefore largest, range from another worker's deque. Chunk sizes thus adapt to
+ * how unevenly the workers progress, e.g. when cores are shared with other processes.
+ *
+ * The scheduler does not create threads: each of the caller's threads (std::thread,
+ * pool job or OpenMP thread) calls run() with its own worker index.
+ */
+class ECE_RangeScheduler
+{
+protected:
+    /**
+     * @brief A half-open index range [begin, end).
+     */
+    struct Range
+    {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    /**
+     * @brief The deque and statistics of one worker, padded to its own cache lines.
+     */
+    struct alignas(64) Worker
+    {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT; // guards ranges
+        std::deque<Range> ranges;                 // owner works at the back, thieves take the front
+        WorkerStats stats;
+    };
+
+    std::vector<Worker> workers;
+    std::atomic<std::size_t> remaining; // indices not processed yet
+    std::size_t grain;                  // ranges at most this long are not split further
+
+    static void acquire(Worker &worker)
+    {
+        while (worker.lock.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    static void release(Worker &worker)
+    {
+        worker.lock.clear(std::memory_order_release);
+    }
+
+    void push(Worker &worker, Range range)
+    {
+        acquire(worker);
+        worker.ranges.push_back(range);
+        release(worker);
+    }
+
+    bool pop(Worker &worker, Range &range)
+    {
+        acquire(worker);
+        bool found = !worker.ranges.empty();
+        if (found)
+        {
+            range = worker.ranges.back();
+            worker.ranges.pop_back();
+        }
+        release(worker);
+        return found;
+    }
+
+    bool steal(unsigned thief, Range &range)
+    {
+        for (std::size_t k = 1; k < workers.size(); k++)
+        {
+            Worker &victim = workers[(thief + k) % workers.size()];
+            acquire(victim);
+            bool found = !victim.ranges.empty();
+            if (found)
+            {
+                range = victim.ranges.front();
+                victim.ranges.pop_front();
+            }
+            release(victim);
+            if (found)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    /**
+     * @brief Constructor for ECE_RangeScheduler.
+     *
+     * @param begin first index of the range
+     * @param end one past the last index of the range
+     * @param workerCount number of workers that will call run()
+     * @param grain ranges at most this long are processed in one body call
+     */
+    ECE_RangeScheduler(std::size_t begin, std::size_t end, unsigned workerCount, std::size_t grain)
+            : workers(std::max(workerCount, 1u)), remaining(end - begin), grain(std::max<std::size_t>(grain, 1))
+    {
+        std::size_t count = end - begin;
+        for (std::size_t w = 0; w < workers.size(); w++)
+        {
+            Range block = {begin + count * w / workers.size(), begin + count * (w + 1) / workers.size()};
+            if (block.end > block.begin)
+            {
+                workers[w].ranges.push_back(block);
+            }
+        }
+    }
+
+    /**
+     * @brief A grain giving every worker a few dozen chunks, but never fewer than minimum indices each.
+     *
+     * @param count number of indices in the range
+     * @param workerCount number of workers
+     * @param minimum smallest useful chunk
+     * @return the grain
+     */
+    static std::size_t adaptiveGrain(std::size_t count, unsigned workerCount, std::size_t minimum)
+    {
+        return std::max(minimum, count / (32 * std::max(workerCount, 1u)));
+    }
+
+    /**
+     * @brief Processes ranges until the whole index range is done.
+     *
+     * @param worker index of the calling worker, 0 .. workerCount - 1
+     * @param body called as body(begin, end) for every chunk
+     */
+    template<typename Body>
+    void run(unsigned worker, Body &&body)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        Worker &self = workers[worker % workers.size()];
+        Range range{};
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            bool found = pop(self, range);
+            if (!found && steal(worker, range))
+            {
+                found = true;
+                self.stats.steals++;
+            }
+            if (!found)
+            {
+                // the last ranges are being processed by other workers
+                std::this_thread::yield();
+                continue;
+            }
+
+            while (range.end - range.begin > grain)
+            {
+                std::size_t middle = range.begin + (range.end - range.begin) / 2;
+                push(self, {middle, range.end});
+                range.end = middle;
+            }
+
+            auto bodyStart = Clock::now();
+            body(range.begin, range.end);
+            self.stats.busySeconds += std::chrono::duration<double>(Clock::now() - bodyStart).count();
+            self.stats.items += range.end - range.begin;
+            self.stats.chunks++;
+            remaining.fetch_sub(range.end - range.begin, std::memory_order_acq_rel);
+        }
+        self.stats.totalSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief Getter for the statistics of every worker.
+     *
+     * @return one entry per worker
+     */
+    std::vector<WorkerStats> getStats() const
+    {
+        std::vector<WorkerStats> stats;
+        for (const Worker &worker: workers)
+        {
+            stats.push_back(worker.stats);
+        }
+        return stats;
+    }
+};
+
+/**
+ * @brief Prints per-worker timing and the load imbalance of a scheduled loop.
+ *
+ * @param out the stream to print to
+ * @param stats one entry per worker
+ */
+inline void printWorkerStats(std::ostream &out, const std::vector<WorkerStats> &stats)
+{
+    double maxBusy = 0, sumBusy = 0;
+    for (std::size_t w = 0; w < stats.size(); w++)
+    {
+        out << "Worker " << w << ": " << stats[w].items << " items in " << stats[w].chunks << " chunks ("
+            << stats[w].steals << " stolen), busy " << std::fixed << std::setprecision(1)
+            << stats[w].busySeconds * 1e6 << " of " << stats[w].totalSeconds * 1e6 << " microsec" << std::endl;
+        maxBusy = std::max(maxBusy, stats[w].busySeconds);
+        sumBusy += stats[w].busySeconds;
+    }
+    if (sumBusy > 0)
+    {
+        out << "Load imbalance (max / mean busy time): " << std::setprecision(3)
+            << maxBusy / (sumBusy / stats.size()) << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+
+#endif //ECE_RANGESCHEDULER_H
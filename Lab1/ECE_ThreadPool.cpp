@@ -0,0 +1,165 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the persistent worker pool fed by a lock-free job queue
+ * */
+
+#include "ECE_ThreadPool.h"
+
+//start the workers once, they live until the pool is destroyed
+ECE_ThreadPool::ECE_ThreadPool(unsigned num_workers)
+        : ring(QUEUE_CAPACITY), enqueue_pos(0), dequeue_pos(0), pending(0), parked(0), stopping(false)
+{
+    for (size_t i = 0; i < QUEUE_CAPACITY; ++i)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    for (unsigned i = 0; i < num_workers; ++i)
+        workers.emplace_back(&ECE_ThreadPool::workerLoop, this, i);
+}
+
+//wake every worker and join them
+ECE_ThreadPool::~ECE_ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(park_mutex);
+        stopping.store(true);
+    }
+    park_cv.notify_all();
+    for (std::thread &worker: workers)
+        worker.join();
+}
+
+unsigned ECE_ThreadPool::size() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+//queue a job, helping with queued work while the ring is full
+void ECE_ThreadPool::submit(ECE_Job job)
+{
+    pending.fetch_add(1, std::memory_order_relaxed);
+    while (!tryPush(job))
+    {
+        ECE_Job other;
+        if (tryPop(other))
+        {
+            other(size());
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+    }
+    // Pairs with the fetch_add in workerLoop: either the worker's re-check sees the push or this load
+    // sees the worker parked. Only then is the lock taken, which orders the push before the re-check.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed) != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(park_mutex);
+        }
+        park_cv.notify_one();
+    }
+}
+
+//run queued jobs on the calling thread until every submitted job has finished
+void ECE_ThreadPool::wait()
+{
+    while (pending.load(std::memory_order_acquire) != 0)
+    {
+        ECE_Job job;
+        if (tryPop(job))
+        {
+            job(size());
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool ECE_ThreadPool::tryPush(ECE_Job &job)
+{
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot &slot = ring[pos & (QUEUE_CAPACITY - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.job = std::move(job);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;  // full
+        }
+        else
+        {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ECE_ThreadPool::tryPop(ECE_Job &job)
+{
+    size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot &slot = ring[pos & (QUEUE_CAPACITY - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0)
+        {
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                job = std::move(slot.job);
+                slot.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;  // empty
+        }
+        else
+        {
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//poll the queue, spinning briefly before parking so back-to-back queries stay hot
+void ECE_ThreadPool::workerLoop(unsigned worker_id)
+{
+    int idle_polls = 0;
+    while (true)
+    {
+        ECE_Job job;
+        if (tryPop(job))
+        {
+            job(worker_id);
+            pending.fetch_sub(1, std::memory_order_release);
+            idle_polls = 0;
+            continue;
+        }
+        if (stopping.load(std::memory_order_relaxed))
+            return;
+        if (++idle_polls < SPIN_LIMIT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(park_mutex);
+        parked.fetch_add(1, std::memory_order_seq_cst);
+        park_cv.wait(lock, [this] {
+            return stopping.load() || enqueue_pos.load() != dequeue_pos.load();
+        });
+        parked.fetch_sub(1, std::memory_order_relaxed);
+        idle_polls = 0;
+    }
+}
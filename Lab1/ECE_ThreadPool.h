@@ -0,0 +1,66 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the persistent worker pool fed by a lock-free job queue
+ * */
+
+#ifndef ECE_THREADPOOL_H
+#define ECE_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A job receives the index of the thread running it: 0 .. size() - 1 for the workers,
+// size() for the caller of wait(), which helps draining the queue
+using ECE_Job = std::function<void(unsigned)>;
+
+class ECE_ThreadPool
+{
+public:
+    explicit ECE_ThreadPool(unsigned num_workers);
+    ~ECE_ThreadPool();
+
+    ECE_ThreadPool(const ECE_ThreadPool &) = delete;
+    ECE_ThreadPool &operator=(const ECE_ThreadPool &) = delete;
+
+    unsigned size() const;
+    void submit(ECE_Job job);
+    void wait();
+
+private:
+    // Bounded multi-producer multi-consumer ring (D. Vyukov): a slot is free to write when
+    // its sequence equals the enqueue position and ready to read when it is one ahead
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        ECE_Job job;
+    };
+
+    static constexpr size_t QUEUE_CAPACITY = 1024;  // must be a power of two
+    static constexpr int SPIN_LIMIT = 4096;         // empty polls before a worker parks
+
+    bool tryPush(ECE_Job &job);
+    bool tryPop(ECE_Job &job);
+    void workerLoop(unsigned worker_id);
+
+    std::vector<Slot> ring;
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;
+    alignas(64) std::atomic<size_t> pending;  // submitted jobs that have not finished yet
+    alignas(64) std::atomic<unsigned> parked;  // workers parked or about to park on park_cv
+    std::atomic<bool> stopping;
+
+    // only used to park idle workers, submit locks it only while one is parked
+    std::mutex park_mutex;
+    std::condition_variable park_cv;
+
+    std::vector<std::thread> workers;
+};
+
+#endif //ECE_THREADPOOL_H
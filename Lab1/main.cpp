@@ -1,19 +1,24 @@
 /*
  * Author: Shuojiang Liu
  * Class: ECE 6122
- * Last Date Modified: Sept 24, 2023
+ * Last Date Modified: Oct 18, 2026
  * Description: The main CPP file to calculate electric fields
  * */
 
+#include <array>
 #include <iostream>
 #include <iomanip>
 #include <thread>
 #include <chrono>
 #include <string>
 #include <regex>
-#include <mutex>
 #include <vector>
+#include "ECE_CommandLine.h"
 #include "ECE_ElectricField.h"
+#include "ECE_PerfCounters.h"
+#include "ECE_QueryCache.h"
+#include "ECE_RangeScheduler.h"
+#include "ECE_ThreadPool.h"
 using namespace std;
 
 
@@ -117,14 +122,18 @@ bool check_overlap(const double &x_dist, const double &y_dist,
     return true;
 }
 
-mutex electric_mutex;
+// one partial sum per scheduler worker, padded to a cache line so the workers never share one
+struct alignas(64) PartialField
+{
+    double x = 0, y = 0, z = 0;
+};
 
 /* calculate overall electric electric using multithreading
  * */
 void do_calculation(vector<ECE_ElectricField> &electric,
                     double x_c, double y_c, double z_c,
                     int beginning, int ending,
-                    double &x_field, double &y_field, double &z_field)
+                    PartialField &partial)
 {
     double Ex_val = 0, Ey_val = 0, Ez_val = 0;
     double sum_x = 0, sum_y = 0, sum_z = 0;
@@ -136,41 +145,238 @@ void do_calculation(vector<ECE_ElectricField> &electric,
         sum_y += Ey_val;
         sum_z += Ez_val;
     }
-    lock_guard<mutex> locking(electric_mutex);
-    x_field += sum_x;
-    y_field += sum_y;
-    z_field += sum_z;
+    partial.x += sum_x;
+    partial.y += sum_y;
+    partial.z += sum_z;
+}
+
+// charges per leaf of the fixed reduction tree used by "-deterministic"
+const int REDUCTION_BLOCK = 256;
+
+/* add value to sum, keeping the rounding error in compensation (Neumaier)
+ * */
+void compensated_add(double &sum, double &compensation, double value)
+{
+    double total = sum + value;
+    if (abs(sum) >= abs(value))
+        compensation += (sum - total) + value;
+    else
+        compensation += (value - total) + sum;
+    sum = total;
+}
+
+/* sum one fixed block of charges with compensated additions
+ * */
+void do_block_calculation(vector<ECE_ElectricField> &electric,
+                          double x_c, double y_c, double z_c,
+                          int beginning, int ending,
+                          PartialField &block)
+{
+    double Ex_val = 0, Ey_val = 0, Ez_val = 0;
+    double sum_x = 0, sum_y = 0, sum_z = 0;
+    double comp_x = 0, comp_y = 0, comp_z = 0;
+    for (int i = beginning; i < ending; i++)
+    {
+        electric[i].computeFieldAt(x_c, y_c, z_c);
+        electric[i].getElectricField(Ex_val, Ey_val, Ez_val);
+        compensated_add(sum_x, comp_x, Ex_val);
+        compensated_add(sum_y, comp_y, Ey_val);
+        compensated_add(sum_z, comp_z, Ez_val);
+    }
+    block.x = sum_x + comp_x;
+    block.y = sum_y + comp_y;
+    block.z = sum_z + comp_z;
+}
+
+/* add the block sums with a fixed pairwise tree, neighbouring pairs level by level,
+ * so the result does not depend on which thread computed which block
+ * */
+PartialField pairwise_sum(vector<PartialField> &blocks)
+{
+    if (blocks.empty())
+        return PartialField();
+    for (size_t count = blocks.size(); count > 1; count = (count + 1) / 2)
+    {
+        for (size_t i = 0; i < count / 2; ++i)
+        {
+            blocks[i].x = blocks[2 * i].x + blocks[2 * i + 1].x;
+            blocks[i].y = blocks[2 * i].y + blocks[2 * i + 1].y;
+            blocks[i].z = blocks[2 * i].z + blocks[2 * i + 1].z;
+        }
+        if (count % 2)
+            blocks[count / 2] = blocks[count - 1];
+    }
+    return blocks[0];
+}
+
+/* compute the field at one target with the pool, one scheduler worker per job,
+ * ranges are split and stolen as the workers progress; with perf set every job
+ * also reads the performance counters of the thread running it
+ * */
+PartialField compute_field(ECE_ThreadPool &pool, vector<ECE_ElectricField> &electric_field,
+                           unsigned int max_threads, bool deterministic,
+                           double x_target, double y_target, double z_target,
+                           vector<WorkerStats> &stats, vector<PerfSample> *perf = nullptr)
+{
+    if (perf)
+        perf->assign(max_threads, PerfSample());
+    vector<PartialField> partials(max_threads);
+    size_t charge_count = electric_field.size();
+    size_t block_count = (charge_count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    size_t work_items = deterministic ? block_count : charge_count;
+    vector<PartialField> blocks(deterministic ? block_count : 0);
+    ECE_RangeScheduler scheduler(0, work_items, max_threads,
+                                 ECE_RangeScheduler::adaptiveGrain(work_items, max_threads,
+                                                                   deterministic ? 4 : 1024));
+    for (unsigned int i = 0; i < max_threads; ++i)
+    {
+        pool.submit([&, x_target, y_target, z_target, i](unsigned) {
+            if (perf)
+                ECE_PerfCounters::thisThread().start();
+            scheduler.run(i, [&](size_t beginning, size_t ending) {
+                if (!deterministic)
+                {
+                    do_calculation(electric_field, x_target, y_target, z_target,
+                                   static_cast<int>(beginning), static_cast<int>(ending), partials[i]);
+                    return;
+                }
+                // in deterministic mode the scheduler hands out fixed blocks, each summed into its own slot
+                for (size_t block = beginning; block < ending; ++block)
+                    do_block_calculation(electric_field, x_target, y_target, z_target,
+                                         static_cast<int>(block * REDUCTION_BLOCK),
+                                         static_cast<int>(min((block + 1) * REDUCTION_BLOCK, charge_count)),
+                                         blocks[block]);
+            });
+            if (perf)
+                (*perf)[i] = ECE_PerfCounters::thisThread().stop();
+        });
+    }
+    pool.wait();
+    stats = scheduler.getStats();
+
+    // reduce the per-job partial sums, no lock needed once every job has finished
+    if (deterministic)
+        return pairwise_sum(blocks);
+    PartialField total;
+    for (const PartialField &partial: partials)
+    {
+        total.x += partial.x;
+        total.y += partial.y;
+        total.z += partial.z;
+    }
+    return total;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     bool finish = false;
 
+    // "-stats" prints the per-worker timing of every query,
+    // "-deterministic" gives bit-for-bit identical results for any thread count,
+    // "-threads", "-grid", "-sep" and "-charge" answer the matching prompt, every "-point x y z"
+    // is evaluated "-repeat" times without prompting and printed as one CSV line,
+    // "-cache <entries>" answers repeated locations from an LRU cache of computed fields,
+    // "-perf" prints per-worker hardware counters, interactions per cycle and GFLOP/s of every query,
+    // "-config <file>" reads the same options from a file, one per line without the dash
+    vector<string> args;
+    string config_error;
+    if (!expandConfigFiles(argc, argv, args, config_error))
+    {
+        cerr << "Cannot read config file " << config_error << endl;
+        return 1;
+    }
+    bool print_stats = false, deterministic = false, profile = false, valid_arguments = true;
+    unsigned int max_threads = 0;
+    int N_row = 0, M_column = 0, repeat = 1;
+    size_t cache_capacity = 0;
+    double x_sep = 0, y_sep = 0, q = 0;
+    bool charge_given = false;
+    vector<array<double, 3>> batch_points;
+    for (size_t arg = 0; valid_arguments && arg < args.size(); ++arg)
+    {
+        const string &option = args[arg];
+        size_t value_count = (option == "-grid" || option == "-sep") ? 2 : option == "-point" ? 3 :
+                             (option == "-stats" || option == "-deterministic" || option == "-perf") ? 0 : 1;
+        if (arg + value_count >= args.size())
+        {
+            valid_arguments = false;
+            break;
+        }
+        vector<string> values(args.begin() + arg + 1, args.begin() + arg + 1 + value_count);
+        arg += value_count;
+        if (option == "-stats")
+            print_stats = true;
+        else if (option == "-deterministic")
+            deterministic = true;
+        else if (option == "-perf")
+            profile = true;
+        else if (option == "-threads" && is_natural(values[0]))
+            max_threads = stoi(values[0]);
+        else if (option == "-repeat" && is_natural(values[0]))
+            repeat = stoi(values[0]);
+        else if (option == "-cache" && is_natural(values[0]))
+            cache_capacity = stoul(values[0]);
+        else if (option == "-charge" && is_digit(values[0]))
+        {
+            q = stod(values[0]);
+            charge_given = true;
+        }
+        else if (option == "-grid" && is_natural(values[0]) && is_natural(values[1]))
+        {
+            N_row = stoi(values[0]);
+            M_column = stoi(values[1]);
+        }
+        else if (option == "-sep" && is_digit(values[0], true) && is_digit(values[1], true) &&
+                 stod(values[0]) > 0 && stod(values[1]) > 0)
+        {
+            x_sep = stod(values[0]);
+            y_sep = stod(values[1]);
+        }
+        else if (option == "-point" && is_digit(values[0]) && is_digit(values[1]) && is_digit(values[2]))
+            batch_points.push_back({stod(values[0]), stod(values[1]), stod(values[2])});
+        else
+            valid_arguments = false;
+    }
+    if (!valid_arguments)
+    {
+        cerr << "Usage: " << argv[0] << " [-stats] [-deterministic] [-perf] [-threads <count>] [-grid <N> <M>]"
+             << " [-sep <x> <y>] [-charge <micro C>] [-point <x> <y> <z>]... [-repeat <count>] [-cache <entries>]"
+             << " [-config <file>]"
+             << endl;
+        return 1;
+    }
+
     // Determine the number of threads running concurrently
-    unsigned int max_threads = thread::hardware_concurrency();
-    cout << endl << "Your computer supports " << max_threads << " concurrent threads" << endl;
+    if (max_threads == 0)
+    {
+        max_threads = thread::hardware_concurrency();
+        cout << endl << "Your computer supports " << max_threads << " concurrent threads" << endl;
+    }
+
+    // Start the workers once, the calling thread joins in while waiting for each query
+    ECE_ThreadPool pool(max_threads - 1);
 
     char delimiter = ' ';
     // Prompt the user for the size of the array and make sure it is valid
     string user_get;
     vector<string> n_rows_and_columns;
-    do
+    while (N_row == 0)
     {
         n_rows_and_columns.clear();
         cout << "Please enter the number of rows and columns in the N_row x_sep M_column array: ";
         getline(cin, user_get);
-    } while (!split(user_get, delimiter, n_rows_and_columns, 2, true, true));
-
-    int N_row = stoi(n_rows_and_columns[0]), M_column = stoi(n_rows_and_columns[1]);
+        if (split(user_get, delimiter, n_rows_and_columns, 2, true, true))
+        {
+            N_row = stoi(n_rows_and_columns[0]);
+            M_column = stoi(n_rows_and_columns[1]);
+        }
+    }
 
     // Prompt the user for the separation distances and make sure it is valid
     string user_distances;
     vector<string> sep_x_and_y;
 
-    bool is_in_range;
-    double x_sep, y_sep;
-    do
+    while (x_sep == 0)
     {
-        is_in_range = true;
         do
         {
             sep_x_and_y.clear();
@@ -183,21 +389,72 @@ int main() {
         if (x_sep <= 0 || y_sep <= 0)
         {
             cout << "Input value range is invalid! Enter again please." << endl;
-            is_in_range = false;
+            x_sep = 0;
         }
-    } while (!is_in_range);
+    }
 
     // Prompt the user for the charge_user and make sure it is valid
     string charge_user;
-    do
+    while (!charge_given)
     {
         charge_user.clear();
         cout << "Please enter the common charge_user on the points in micro C: ";
         getline(cin, charge_user);
+        if (is_digit(charge_user))
+        {
+            q = stod(charge_user);
+            charge_given = true;
+        }
+    }
 
-    } while (!is_digit(charge_user));
-    double q = stod(charge_user);
+    // Build the grid once, every location query below reuses it
+    vector<ECE_ElectricField> electric_field;
+    electric_field.reserve(static_cast<size_t>(N_row) * M_column);
+    for (int i = 0; i < N_row; ++i)
+        for (int j = 0; j < M_column; ++j)
+            electric_field.emplace_back(x_sep * i - (N_row - 1) * x_sep / 2,
+                                        y_sep * j - (M_column - 1) * y_sep / 2, 0, q);
 
+    // batch mode: time every given point "repeat" times, one pair interaction per charge and point
+    if (!batch_points.empty())
+    {
+        cout << "x,y,z,Ex,Ey,Ez,E,mean_us,stddev_us,min_us,interactions_per_s" << endl;
+        for (const auto &point: batch_points)
+        {
+            if (!check_overlap(x_sep, y_sep, point[0], point[1], point[2], N_row, M_column))
+            {
+                cerr << "Skipping (" << point[0] << ", " << point[1] << ", " << point[2]
+                     << "), it overlaps with the grid" << endl;
+                continue;
+            }
+            PartialField total;
+            vector<WorkerStats> stats;
+            vector<PerfSample> perf;
+            vector<double> samples;
+            for (int run = 0; run < repeat; ++run)
+            {
+                auto start = chrono::high_resolution_clock::now();
+                total = compute_field(pool, electric_field, max_threads, deterministic,
+                                      point[0], point[1], point[2], stats, profile ? &perf : nullptr);
+                samples.push_back(chrono::duration<double, micro>(chrono::high_resolution_clock::now() - start).count());
+            }
+            SampleSummary time = summarizeSamples(samples);
+            if (profile)
+            {
+                // the CSV stays on standard output, the counters of the last run go to standard error
+                cerr << "Counters at (" << point[0] << ", " << point[1] << ", " << point[2] << "):" << endl;
+                printPerfReport(cerr, perf, static_cast<double>(electric_field.size()), samples.back() * 1e-6);
+            }
+            cout << setprecision(10) << point[0] << "," << point[1] << "," << point[2] << "," << total.x << ","
+                 << total.y << "," << total.z << "," << sqrt(total.x * total.x + total.y * total.y + total.z * total.z)
+                 << "," << setprecision(6) << time.mean << "," << time.stddev << "," << time.min << ","
+                 << static_cast<double>(electric_field.size()) / (time.mean * 1e-6) << endl;
+        }
+        return 0;
+    }
+
+    // repeated locations are answered from the cache, the grid above never changes within a run
+    ECE_LruCache<GridQuery, PartialField, GridQueryHash> cache(cache_capacity);
     while (!finish)
     {
         // Input coordinates
@@ -223,37 +480,22 @@ int main() {
             continue;
         }
 
-        vector<ECE_ElectricField> electric_field;
-        for (int i = 0; i < N_row; ++i)
-            for (int j = 0; j < M_column; ++j)
-                electric_field.emplace_back(x_sep * i - (N_row - 1) * x_sep / 2,
-                                                           y_sep * j - (M_column - 1) * y_sep / 2, 0, q);
-
-        vector<thread> calculation_threads;
         double x_field = 0, y_field = 0, z_field = 0;
-        int beginning = 0;
-        int ending = 0;
-        int blocks = M_column * N_row / max_threads;
         int x_power = 0, y_power = 0, z_power = 0, electric_power = 0;
+        vector<WorkerStats> stats;
+        vector<PerfSample> perf;
 
         auto startTimePoint = chrono::high_resolution_clock::now();
-
-        for (int i = 0; i < max_threads - 1; ++i)
-        {
-            ending = beginning + blocks;
-            calculation_threads.emplace_back(do_calculation, ref(electric_field),
-                                             x_target, y_target, z_target,
-                                             beginning, ending,
-                                             ref(x_field), ref(y_field), ref(z_field));
-            beginning = ending;
-        }
-        do_calculation(electric_field,
-                       x_target, y_target, z_target,
-                       beginning, electric_field.size(),
-                       x_field, y_field, z_field);
-
-        for (thread &item: calculation_threads) item.join();
-
+        GridQuery query = {N_row, M_column, x_sep, y_sep, q, x_target, y_target, z_target};
+        const PartialField *cached = cache_capacity > 0 ? cache.find(query) : nullptr;
+        PartialField total = cached ? *cached : compute_field(pool, electric_field, max_threads, deterministic,
+                                                              x_target, y_target, z_target, stats,
+                                                              profile ? &perf : nullptr);
+        if (cache_capacity > 0 && !cached)
+            cache.insert(query, total);
+        x_field = total.x;
+        y_field = total.y;
+        z_field = total.z;
         auto stopTimePoint = chrono::high_resolution_clock::now();
         auto duration = chrono::duration_cast<chrono::microseconds>(stopTimePoint - startTimePoint);
 
@@ -279,7 +521,11 @@ int main() {
         cout << "|E| = " << fixed << setprecision(4) << abs_electric / pow(10, electric_power)
         << " * 10^" << electric_power << endl;
 
-        cout << "The calculation took " << duration.count() << " microsec!" << endl;
+        cout << "The calculation took " << duration.count() << " microsec!" << (cached ? " (cached)" : "") << endl;
+        if (print_stats && !cached)
+            printWorkerStats(cout, stats);
+        if (profile && !cached)
+            printPerfReport(cout, perf, static_cast<double>(electric_field.size()), duration.count() * 1e-6);
 
         do
         {
@@ -289,6 +535,9 @@ int main() {
             if (yes_or_no == "n" || yes_or_no == "N")
             {
                 finish = true;
+                if (cache_capacity > 0)
+                    cout << "Query cache: " << cache.getStats().hits << " hits, " << cache.getStats().misses
+                         << " misses, " << cache.getStats().evictions << " evictions" << endl;
                 cout << "Bye!" << endl;
                 break;
             }
@@ -0,0 +1,271 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the Barnes-Hut octree approximating the electric field of many charges
+ * */
+
+#include "ECE_BarnesHut.h"
+#include "ECE_ElectricField.h"
+#include "ECE_FieldKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+ECE_BarnesHut::ECE_BarnesHut(const ECE_ChargeArray &charges, double theta, int numThreads) : theta(theta)
+{
+    std::size_t count = charges.size();
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+
+    // bounding cube of all charges
+    double minX = HUGE_VAL, minY = HUGE_VAL, minZ = HUGE_VAL;
+    double maxX = -HUGE_VAL, maxY = -HUGE_VAL, maxZ = -HUGE_VAL;
+#pragma omp parallel for reduction(min:minX, minY, minZ) reduction(max:maxX, maxY, maxZ) num_threads(numThreads)
+    for (std::size_t i = 0; i < count; i++)
+    {
+        minX = std::min(minX, xs[i]);
+        minY = std::min(minY, ys[i]);
+        minZ = std::min(minZ, zs[i]);
+        maxX = std::max(maxX, xs[i]);
+        maxY = std::max(maxY, ys[i]);
+        maxZ = std::max(maxZ, zs[i]);
+    }
+
+    root = std::make_unique<Node>();
+    root->begin = 0;
+    root->end = count;
+    if (count == 0)
+    {
+        root->isLeaf = true;
+        return;
+    }
+    root->centerX = (minX + maxX) / 2;
+    root->centerY = (minY + maxY) / 2;
+    root->centerZ = (minZ + maxZ) / 2;
+    double extent = std::max({maxX - minX, maxY - minY, maxZ - minZ});
+    root->halfSize = extent > 0 ? extent / 2 * (1 + 1e-12) : 1.0;
+
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+
+#pragma omp parallel num_threads(numThreads)
+#pragma omp single
+    buildNode(*root, charges, order, 0);
+
+    sorted.reserve(count);
+    for (std::size_t i: order)
+    {
+        sorted.addCharge(xs[i], ys[i], zs[i], charges.qData()[i]);
+    }
+}
+
+void ECE_BarnesHut::buildNode(Node &node, const ECE_ChargeArray &charges, std::vector<std::size_t> &order, int depth)
+{
+    std::size_t count = node.end - node.begin;
+    if (count <= BH_LEAF_SIZE || depth >= BH_MAX_DEPTH)
+    {
+        node.isLeaf = true;
+        computeLeafMoments(node, charges, order);
+        return;
+    }
+    node.isLeaf = false;
+
+    // bucket the node's charges by octant, bit 0 = x, bit 1 = y, bit 2 = z
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    std::vector<unsigned char> octant(count);
+    std::size_t octantCount[8] = {};
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::size_t c = order[node.begin + i];
+        octant[i] = static_cast<unsigned char>((xs[c] >= node.centerX) | ((ys[c] >= node.centerY) << 1)
+                                               | ((zs[c] >= node.centerZ) << 2));
+        octantCount[octant[i]]++;
+    }
+    std::size_t offset[8];
+    offset[0] = 0;
+    for (int k = 1; k < 8; k++)
+    {
+        offset[k] = offset[k - 1] + octantCount[k - 1];
+    }
+    std::vector<std::size_t> bucketed(count);
+    std::size_t cursor[8];
+    std::copy(offset, offset + 8, cursor);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        bucketed[cursor[octant[i]]++] = order[node.begin + i];
+    }
+    std::copy(bucketed.begin(), bucketed.end(), order.begin() + node.begin);
+
+    double childHalf = node.halfSize / 2;
+    for (int k = 0; k < 8; k++)
+    {
+        if (octantCount[k] == 0)
+        {
+            continue;
+        }
+        node.children[k] = std::make_unique<Node>();
+        Node &child = *node.children[k];
+        child.centerX = node.centerX + ((k & 1) ? childHalf : -childHalf);
+        child.centerY = node.centerY + ((k & 2) ? childHalf : -childHalf);
+        child.centerZ = node.centerZ + ((k & 4) ? childHalf : -childHalf);
+        child.halfSize = childHalf;
+        child.begin = node.begin + offset[k];
+        child.end = child.begin + octantCount[k];
+
+        // children own disjoint ranges of order, so they can be built concurrently
+#pragma omp task shared(child, charges, order) firstprivate(depth) if(octantCount[k] > BH_TASK_CUTOFF)
+        buildNode(child, charges, order, depth + 1);
+    }
+#pragma omp taskwait
+
+    combineChildMoments(node);
+}
+
+void ECE_BarnesHut::computeLeafMoments(Node &node, const ECE_ChargeArray &charges, const std::vector<std::size_t> &order)
+{
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+
+    node.absCharge = 0;
+    node.charge = 0;
+    double sumX = 0, sumY = 0, sumZ = 0;
+    for (std::size_t i = node.begin; i < node.end; i++)
+    {
+        std::size_t c = order[i];
+        double w = std::fabs(qs[c]);
+        node.absCharge += w;
+        node.charge += qs[c];
+        sumX += w * xs[c];
+        sumY += w * ys[c];
+        sumZ += w * zs[c];
+    }
+    if (node.absCharge > 0)
+    {
+        node.cx = sumX / node.absCharge;
+        node.cy = sumY / node.absCharge;
+        node.cz = sumZ / node.absCharge;
+    }
+    else
+    {
+        node.cx = node.centerX;
+        node.cy = node.centerY;
+        node.cz = node.centerZ;
+    }
+
+    node.px = 0;
+    node.py = 0;
+    node.pz = 0;
+    for (std::size_t i = node.begin; i < node.end; i++)
+    {
+        std::size_t c = order[i];
+        node.px += qs[c] * (xs[c] - node.cx);
+        node.py += qs[c] * (ys[c] - node.cy);
+        node.pz += qs[c] * (zs[c] - node.cz);
+    }
+}
+
+void ECE_BarnesHut::combineChildMoments(Node &node)
+{
+    node.absCharge = 0;
+    node.charge = 0;
+    double sumX = 0, sumY = 0, sumZ = 0;
+    for (const auto &child: node.children)
+    {
+        if (child)
+        {
+            node.absCharge += child->absCharge;
+            node.charge += child->charge;
+            sumX += child->absCharge * child->cx;
+            sumY += child->absCharge * child->cy;
+            sumZ += child->absCharge * child->cz;
+        }
+    }
+    if (node.absCharge > 0)
+    {
+        node.cx = sumX / node.absCharge;
+        node.cy = sumY / node.absCharge;
+        node.cz = sumZ / node.absCharge;
+    }
+    else
+    {
+        node.cx = node.centerX;
+        node.cy = node.centerY;
+        node.cz = node.centerZ;
+    }
+
+    // shift every child dipole to the new expansion center
+    node.px = 0;
+    node.py = 0;
+    node.pz = 0;
+    for (const auto &child: node.children)
+    {
+        if (child)
+        {
+            node.px += child->px + child->charge * (child->cx - node.cx);
+            node.py += child->py + child->charge * (child->cy - node.cy);
+            node.pz += child->pz + child->charge * (child->cz - node.cz);
+        }
+    }
+}
+
+FieldVector ECE_BarnesHut::computeField(double x, double y, double z) const
+{
+    double Ex = 0, Ey = 0, Ez = 0;
+    double thetaSquared = theta * theta;
+
+    std::vector<const Node *> stack;
+    stack.push_back(root.get());
+    while (!stack.empty())
+    {
+        const Node *node = stack.back();
+        stack.pop_back();
+
+        if (node->isLeaf)
+        {
+            sumFieldAt(sorted, node->begin, node->end, x, y, z, Ex, Ey, Ez);
+            continue;
+        }
+
+        double dx = x - node->cx;
+        double dy = y - node->cy;
+        double dz = z - node->cz;
+        double r2 = dx * dx + dy * dy + dz * dz;
+        double size = 2 * node->halfSize;
+        bool inside = std::fabs(x - node->centerX) <= node->halfSize && std::fabs(y - node->centerY) <= node->halfSize
+                      && std::fabs(z - node->centerZ) <= node->halfSize;
+
+        if (!inside && size * size < thetaSquared * r2)
+        {
+            // monopole plus dipole field about the expansion center
+            double invR2 = 1 / r2;
+            double invR3 = invR2 / std::sqrt(r2);
+            double pDotD = node->px * dx + node->py * dy + node->pz * dz;
+            double radial = (node->charge + 3 * pDotD * invR2) * invR3;
+            Ex += K * (radial * dx - node->px * invR3);
+            Ey += K * (radial * dy - node->py * invR3);
+            Ez += K * (radial * dz - node->pz * invR3);
+        }
+        else
+        {
+            for (const auto &child: node->children)
+            {
+                if (child)
+                {
+                    stack.push_back(child.get());
+                }
+            }
+        }
+    }
+    return {Ex, Ey, Ez};
+}
+
+double ECE_BarnesHut::getTheta() const
+{
+    return theta;
+}
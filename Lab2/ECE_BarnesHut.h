@@ -0,0 +1,86 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the Barnes-Hut octree approximating the electric field of many charges
+ * */
+
+#ifndef LAB2_ECE_BARNESHUT_H
+#define LAB2_ECE_BARNESHUT_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+const std::size_t BH_LEAF_SIZE = 16;     // maximum number of charges summed directly in a leaf
+const std::size_t BH_TASK_CUTOFF = 4096; // subtrees smaller than this are built without spawning a task
+const int BH_MAX_DEPTH = 32;             // stops subdividing coincident charges
+
+/**
+ * @brief A Barnes-Hut octree over a charge array.
+ *
+ * Every node stores the monopole and dipole moment of its charges about their
+ * center of charge. A node whose size s and distance d to the target satisfy
+ * s / d < theta is replaced by its expansion, otherwise its children are visited.
+ * theta = 0 reproduces the direct sum.
+ */
+class ECE_BarnesHut
+{
+protected:
+    /**
+     * @brief A cubic cell of the octree.
+     */
+    struct Node
+    {
+        double centerX, centerY, centerZ; // geometric center of the cube
+        double halfSize;                  // half of the edge length of the cube
+        double absCharge;                 // sum of |q|, weight of the expansion center
+        double charge;                    // monopole moment, sum of q
+        double cx, cy, cz;                // expansion center, weighted by |q|
+        double px, py, pz;                // dipole moment about the expansion center
+        std::size_t begin, end;           // range of the node's charges in the sorted array
+        std::unique_ptr<Node> children[8];
+        bool isLeaf;
+    };
+
+    ECE_ChargeArray sorted;     // the charges reordered so that every node owns a contiguous range
+    std::unique_ptr<Node> root; // root of the tree
+    double theta;               // opening angle
+
+    void buildNode(Node &node, const ECE_ChargeArray &charges, std::vector<std::size_t> &order, int depth);
+    static void computeLeafMoments(Node &node, const ECE_ChargeArray &charges, const std::vector<std::size_t> &order);
+    static void combineChildMoments(Node &node);
+public:
+    /**
+     * @brief Constructor for ECE_BarnesHut.
+     *
+     * Builds the tree in parallel, one OpenMP task per sufficiently large subtree.
+     *
+     * @param charges the charges producing the field
+     * @param theta opening angle, larger values are faster and less accurate
+     * @param numThreads number of OpenMP threads used for the build
+     */
+    ECE_BarnesHut(const ECE_ChargeArray &charges, double theta, int numThreads);
+
+    /**
+     * @brief Computes the approximate electric field at a single point.
+     *
+     * @param x x coordinate of the point
+     * @param y y coordinate of the point
+     * @param z z coordinate of the point
+     * @return the electric field at the point
+     */
+    FieldVector computeField(double x, double y, double z) const;
+
+    /**
+     * @brief Getter for the opening angle.
+     *
+     * @return the opening angle theta
+     */
+    double getTheta() const;
+};
+
+
+#endif //LAB2_ECE_BARNESHUT_H
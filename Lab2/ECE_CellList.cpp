@@ -0,0 +1,152 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Implementation of the spatial hash evaluating short-range fields within a cutoff radius
+ * */
+
+#include "ECE_CellList.h"
+#include "ECE_ElectricField.h"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+/**
+ * @brief Sums the interaction of charges [begin, end) within the cutoff, chosen at compile time.
+ */
+template<InteractionType Type>
+static void sumShortRange(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end, double x, double y,
+                          double z, double cutoffSquared, double inverseScreening, double &sumX, double &sumY,
+                          double &sumZ)
+{
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+    for (std::size_t i = begin; i < end; i++)
+    {
+        double dx = x - xs[i];
+        double dy = y - ys[i];
+        double dz = z - zs[i];
+        double r2 = dx * dx + dy * dy + dz * dz;
+        if (r2 >= cutoffSquared)
+        {
+            continue;
+        }
+        double r = std::sqrt(r2);
+        double s = qs[i] / (r2 * r);
+        if constexpr (Type == InteractionType::Yukawa)
+        {
+            double scaled = r * inverseScreening;
+            s *= std::exp(-scaled) * (1 + scaled);
+        }
+        sumX += dx * s;
+        sumY += dy * s;
+        sumZ += dz * s;
+    }
+}
+
+ECE_CellList::ECE_CellList(const ECE_ChargeArray &charges, double cutoff, InteractionType type,
+                           double screeningLength, int numThreads)
+        : cutoff(cutoff), type(type),
+          inverseScreening(type == InteractionType::Yukawa ? 1 / screeningLength : 0)
+{
+    // about one charge per bucket keeps collisions rare
+    std::size_t count = charges.size();
+    std::size_t buckets = 1;
+    while (buckets < count)
+    {
+        buckets *= 2;
+    }
+    bucketMask = buckets - 1;
+
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+    std::vector<std::size_t> bucket(count);
+#pragma omp parallel for num_threads(numThreads)
+    for (std::size_t i = 0; i < count; i++)
+    {
+        bucket[i] = bucketOf(cellOf(xs[i]), cellOf(ys[i]), cellOf(zs[i]));
+    }
+
+    // counting sort by bucket
+    bucketStart.assign(buckets + 1, 0);
+    for (std::size_t b: bucket)
+    {
+        bucketStart[b + 1]++;
+    }
+    for (std::size_t b = 0; b < buckets; b++)
+    {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+    std::vector<std::size_t> order(count), cursor(bucketStart.begin(), bucketStart.end() - 1);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        order[cursor[bucket[i]]++] = i;
+    }
+    sorted = ECE_ChargeArray::generate(count, numThreads,
+                                       [&](std::size_t k, double &x, double &y, double &z, double &q) {
+                                           x = xs[order[k]];
+                                           y = ys[order[k]];
+                                           z = zs[order[k]];
+                                           q = qs[order[k]];
+                                       });
+}
+
+std::int64_t ECE_CellList::cellOf(double coordinate) const
+{
+    return static_cast<std::int64_t>(std::floor(coordinate / cutoff));
+}
+
+std::size_t ECE_CellList::bucketOf(std::int64_t cx, std::int64_t cy, std::int64_t cz) const
+{
+    // the primes of Teschner et al., Optimized Spatial Hashing for Collision Detection of Deformable Objects
+    auto hash = static_cast<std::uint64_t>(cx) * 73856093ULL ^ static_cast<std::uint64_t>(cy) * 19349663ULL ^
+                static_cast<std::uint64_t>(cz) * 83492791ULL;
+    hash ^= hash >> 29;
+    return static_cast<std::size_t>(hash * 0x9e3779b97f4a7c15ULL >> 17 & bucketMask);
+}
+
+FieldVector ECE_CellList::computeField(double x, double y, double z) const
+{
+    // neighbouring cells that collide share a bucket, which must only be summed once
+    std::size_t buckets[27];
+    int bucketCount = 0;
+    std::int64_t cx = cellOf(x), cy = cellOf(y), cz = cellOf(z);
+    for (std::int64_t i = cx - 1; i <= cx + 1; i++)
+    {
+        for (std::int64_t j = cy - 1; j <= cy + 1; j++)
+        {
+            for (std::int64_t k = cz - 1; k <= cz + 1; k++)
+            {
+                buckets[bucketCount++] = bucketOf(i, j, k);
+            }
+        }
+    }
+    std::sort(buckets, buckets + bucketCount);
+    bucketCount = static_cast<int>(std::unique(buckets, buckets + bucketCount) - buckets);
+
+    double sumX = 0, sumY = 0, sumZ = 0, cutoffSquared = cutoff * cutoff;
+    for (int b = 0; b < bucketCount; b++)
+    {
+        std::size_t begin = bucketStart[buckets[b]], end = bucketStart[buckets[b] + 1];
+        if (type == InteractionType::Yukawa)
+        {
+            sumShortRange<InteractionType::Yukawa>(sorted, begin, end, x, y, z, cutoffSquared, inverseScreening,
+                                                   sumX, sumY, sumZ);
+        }
+        else
+        {
+            sumShortRange<InteractionType::Coulomb>(sorted, begin, end, x, y, z, cutoffSquared, 0,
+                                                    sumX, sumY, sumZ);
+        }
+    }
+    return {K * sumX, K * sumY, K * sumZ};
+}
+
+double ECE_CellList::getCutoff() const
+{
+    return cutoff;
+}
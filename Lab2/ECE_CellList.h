@@ -0,0 +1,83 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the spatial hash evaluating short-range fields within a cutoff radius
+ * */
+
+#ifndef LAB2_ECE_CELLLIST_H
+#define LAB2_ECE_CELLLIST_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const double YUKAWA_DEFAULT_CUTOFF = 10; // default cutoff in screening lengths, e^-10 of the field is dropped
+
+/**
+ * @brief The pair interaction summed by ECE_CellList.
+ */
+enum class InteractionType
+{
+    Coulomb, // K q / r^2, truncated at the cutoff
+    Yukawa   // screened K q e^(-r / lambda) (1 + r / lambda) / r^2, truncated at the cutoff
+};
+
+/**
+ * @brief A spatial hash of the charges with cells as wide as the cutoff radius.
+ *
+ * Every charge falls into the cubic cell floor(x / cutoff), floor(y / cutoff), floor(z / cutoff),
+ * and the cell is hashed into one of a power-of-two number of buckets. The charges are sorted
+ * by bucket, so a bucket is a contiguous range. Charges within the cutoff of a target lie in
+ * the 27 cells around it, so a query visits at most 27 buckets no matter how far the charges
+ * extend, and a field map costs time linear in its size. Unlike a dense cell grid, memory
+ * only grows with the number of charges, not with the volume they span. Cells that collide in a
+ * bucket only cost the distance test of the extra charges.
+ */
+class ECE_CellList
+{
+protected:
+    ECE_ChargeArray sorted;              // the charges reordered so that every bucket is a contiguous range
+    std::vector<std::size_t> bucketStart; // first charge of every bucket, plus the total at the end
+    std::uint64_t bucketMask;            // number of buckets minus one
+    double cutoff;                       // interaction radius and cell width
+    InteractionType type;                // summed interaction
+    double inverseScreening;             // 1 / lambda for Yukawa, 0 for Coulomb
+
+    std::int64_t cellOf(double coordinate) const;
+    std::size_t bucketOf(std::int64_t cx, std::int64_t cy, std::int64_t cz) const;
+public:
+    /**
+     * @brief Constructor for ECE_CellList.
+     *
+     * @param charges the charges producing the field
+     * @param cutoff radius beyond which charges are ignored
+     * @param type the interaction to sum
+     * @param screeningLength lambda of the Yukawa interaction, ignored for Coulomb
+     * @param numThreads number of OpenMP threads used for the build
+     */
+    ECE_CellList(const ECE_ChargeArray &charges, double cutoff, InteractionType type, double screeningLength,
+                 int numThreads);
+
+    /**
+     * @brief Computes the short-range electric field at a single point.
+     *
+     * @param x x coordinate of the point
+     * @param y y coordinate of the point
+     * @param z z coordinate of the point
+     * @return the field of the charges closer than the cutoff
+     */
+    FieldVector computeField(double x, double y, double z) const;
+
+    /**
+     * @brief Getter for the cutoff radius.
+     *
+     * @return the cutoff radius
+     */
+    double getCutoff() const;
+};
+
+
+#endif //LAB2_ECE_CELLLIST_H
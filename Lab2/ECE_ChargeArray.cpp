@@ -0,0 +1,118 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the structure-of-arrays container of point charges
+ * */
+
+#include "ECE_ChargeArray.h"
+
+void ECE_ChargeArray::detach()
+{
+    if (!owner)
+    {
+        return;
+    }
+    x.assign(borrowed[0], borrowed[0] + borrowedCount);
+    y.assign(borrowed[1], borrowed[1] + borrowedCount);
+    z.assign(borrowed[2], borrowed[2] + borrowedCount);
+    q.assign(borrowed[3], borrowed[3] + borrowedCount);
+    owner.reset();
+}
+
+void ECE_ChargeArray::reserve(std::size_t count)
+{
+    detach();
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+    q.reserve(count);
+}
+
+void ECE_ChargeArray::addCharge(double xCoord, double yCoord, double zCoord, double qValue)
+{
+    detach();
+    planar = planar && zCoord == 0;
+    uniform = uniform && (q.empty() || qValue == q[0]);
+    x.push_back(xCoord);
+    y.push_back(yCoord);
+    z.push_back(zCoord);
+    q.push_back(qValue);
+}
+
+void ECE_ChargeArray::setCharge(std::size_t index, double xCoord, double yCoord, double zCoord, double qValue)
+{
+    detach();
+    planar = planar && zCoord == 0;
+    // the array was uniform before, so any other charge still holds the common value
+    uniform = uniform && (size() == 1 || qValue == q[index == 0 ? 1 : 0]);
+    x[index] = xCoord;
+    y[index] = yCoord;
+    z[index] = zCoord;
+    q[index] = qValue;
+}
+
+std::size_t ECE_ChargeArray::size() const
+{
+    return owner ? borrowedCount : x.size();
+}
+
+bool ECE_ChargeArray::isPlanar() const
+{
+    return planar;
+}
+
+bool ECE_ChargeArray::hasUniformCharge() const
+{
+    return uniform;
+}
+
+ECE_ChargeArray ECE_ChargeArray::makeGrid(int N, int M, double xDistance, double yDistance, double q)
+{
+    return makeGridRows(N, M, xDistance, yDistance, q, 0, N);
+}
+
+ECE_ChargeArray ECE_ChargeArray::makeGridFirstTouch(int N, int M, double xDistance, double yDistance, double q,
+                                                    int numThreads)
+{
+    return generate(static_cast<std::size_t>(N) * M, numThreads,
+                    [=](std::size_t k, double &xC, double &yC, double &zC, double &qC) {
+                        xC = xDistance * (static_cast<double>(k / M) - (N - 1) / 2.0);
+                        yC = yDistance * (static_cast<double>(k % M) - (M - 1) / 2.0);
+                        zC = 0;
+                        qC = q;
+                    });
+}
+
+ECE_ChargeArray ECE_ChargeArray::borrow(std::shared_ptr<const void> arrayOwner, const double *xs, const double *ys,
+                                        const double *zs, const double *qs, std::size_t count, bool isPlanar,
+                                        bool isUniform)
+{
+    ECE_ChargeArray charges;
+    charges.owner = std::move(arrayOwner);
+    charges.borrowed[0] = xs;
+    charges.borrowed[1] = ys;
+    charges.borrowed[2] = zs;
+    charges.borrowed[3] = qs;
+    charges.borrowedCount = count;
+    charges.planar = isPlanar;
+    charges.uniform = isUniform;
+    return charges;
+}
+
+ECE_ChargeArray ECE_ChargeArray::makeGridRows(int N, int M, double xDistance, double yDistance, double q,
+                                              int rowBegin, int rowEnd)
+{
+    ECE_ChargeArray charges;
+    charges.reserve(static_cast<std::size_t>(rowEnd - rowBegin) * M);
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        double xC = xDistance * (i - (N - 1) / 2.0);
+        for (int j = 0; j < M; j++)
+        {
+            double yC = yDistance * (j - (M - 1) / 2.0);
+            charges.addCharge(xC, yC, 0, q);
+        }
+    }
+    return charges;
+}
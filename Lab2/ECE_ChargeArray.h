@@ -0,0 +1,265 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the structure-of-arrays container of point charges
+ * */
+
+#ifndef LAB2_ECE_CHARGEARRAY_H
+#define LAB2_ECE_CHARGEARRAY_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+const std::size_t CHARGE_ALIGNMENT = 64;  // one cache line, also the width of an AVX-512 register
+
+/**
+ * @brief Allocator returning cache-line aligned storage.
+ *
+ * Used so that the SIMD kernels always start on an aligned boundary.
+ *
+ * @tparam T element type
+ */
+template<typename T>
+struct ECE_AlignedAllocator
+{
+    using value_type = T;
+
+    ECE_AlignedAllocator() = default;
+
+    template<typename U>
+    ECE_AlignedAllocator(const ECE_AlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(CHARGE_ALIGNMENT)));
+    }
+
+    void deallocate(T *p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(CHARGE_ALIGNMENT));
+    }
+
+    // resize() leaves new elements uninitialized, so a page is first touched by the thread that fills it
+    template<typename U>
+    void construct(U *p) noexcept
+    {
+        ::new(static_cast<void *>(p)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *p, Args &&... args)
+    {
+        ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    bool operator==(const ECE_AlignedAllocator<U> &) const { return true; }
+
+    template<typename U>
+    bool operator!=(const ECE_AlignedAllocator<U> &) const { return false; }
+};
+
+using AlignedDoubleVector = std::vector<double, ECE_AlignedAllocator<double>>;
+
+/**
+ * @brief A structure-of-arrays collection of point charges.
+ *
+ * Unlike a vector of ECE_PointCharge objects, the x, y, z and q values of all
+ * charges are each stored contiguously, so that the field kernels can stream
+ * them with SIMD loads.
+ *
+ * The arrays can also be borrowed read-only from another owner, e.g. a mapped charge file,
+ * in which case the kernels read that memory directly. Modifying a borrowed collection
+ * first copies it into owned storage.
+ */
+class ECE_ChargeArray
+{
+protected:
+    AlignedDoubleVector x; // x coordinates of the charges
+    AlignedDoubleVector y; // y coordinates of the charges
+    AlignedDoubleVector z; // z coordinates of the charges
+    AlignedDoubleVector q; // charge values
+    bool planar = true;    // every charge has z = 0
+    bool uniform = true;   // every charge has the same value
+    std::shared_ptr<const void> owner;   // keeps borrowed arrays alive, empty for owned storage
+    const double *borrowed[4] = {};      // borrowed x, y, z and q arrays
+    std::size_t borrowedCount = 0;       // number of borrowed charges
+
+    void detach();
+public:
+    /**
+     * @brief Reserves storage for a number of charges.
+     *
+     * @param count the number of charges to reserve space for
+     */
+    void reserve(std::size_t count);
+
+    /**
+     * @brief Appends a charge to the collection.
+     *
+     * @param xCoord x coordinate of the charge
+     * @param yCoord y coordinate of the charge
+     * @param zCoord z coordinate of the charge
+     * @param qValue charge value
+     */
+    void addCharge(double xCoord, double yCoord, double zCoord, double qValue);
+
+    /**
+     * @brief Moves a charge and changes its value.
+     *
+     * @param index index of the charge, must be less than size()
+     * @param xCoord new x coordinate of the charge
+     * @param yCoord new y coordinate of the charge
+     * @param zCoord new z coordinate of the charge
+     * @param qValue new charge value
+     */
+    void setCharge(std::size_t index, double xCoord, double yCoord, double zCoord, double qValue);
+
+    /**
+     * @brief Getter for the number of charges.
+     *
+     * @return the number of charges in the collection
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Checks if every charge lies on the z = 0 plane.
+     *
+     * Tracked as charges are added or changed. Once a charge has left the plane the
+     * array is no longer considered planar, even if the charge moves back.
+     *
+     * @return true if the planar field kernels apply
+     */
+    bool isPlanar() const;
+
+    /**
+     * @brief Checks if every charge carries the same value, tracked like isPlanar.
+     *
+     * @return true if the uniform-charge field kernels apply
+     */
+    bool hasUniformCharge() const;
+
+    const double *xData() const { return owner ? borrowed[0] : x.data(); }
+    const double *yData() const { return owner ? borrowed[1] : y.data(); }
+    const double *zData() const { return owner ? borrowed[2] : z.data(); }
+    const double *qData() const { return owner ? borrowed[3] : q.data(); }
+
+    /**
+     * @brief Wraps arrays owned by someone else without copying them.
+     *
+     * @param arrayOwner keeps the arrays alive as long as any copy of the collection exists
+     * @param xs x coordinates of the charges
+     * @param ys y coordinates of the charges
+     * @param zs z coordinates of the charges
+     * @param qs charge values
+     * @param count number of charges
+     * @param isPlanar true if every charge has z = 0
+     * @param isUniform true if every charge has the same value
+     * @return the charge collection
+     */
+    static ECE_ChargeArray borrow(std::shared_ptr<const void> arrayOwner, const double *xs, const double *ys,
+                                  const double *zs, const double *qs, std::size_t count, bool isPlanar,
+                                  bool isUniform);
+
+    /**
+     * @brief Builds a collection in parallel from a function of the charge index.
+     *
+     * OpenMP thread w fills charges [count * w / numThreads, count * (w + 1) / numThreads),
+     * so every page is first touched by the thread that sums it in the single-point direct sum.
+     * The generator is called as generator(k, x, y, z, q) and must only depend on k.
+     *
+     * @param count number of charges
+     * @param numThreads number of OpenMP threads
+     * @param generator writes the coordinates and value of charge k
+     * @return the charge collection
+     */
+    template<typename Generator>
+    static ECE_ChargeArray generate(std::size_t count, int numThreads, Generator generator);
+
+    /**
+     * @brief Builds the N x M planar grid used by the lab.
+     *
+     * The grid is centered at the origin on the z = 0 plane and every point carries the same charge.
+     *
+     * @param N the number of rows in the grid
+     * @param M the number of columns in the grid
+     * @param xDistance the x distance between two adjacent points
+     * @param yDistance the y distance between two adjacent points
+     * @param q the common charge on each point
+     * @return the charge collection
+     */
+    static ECE_ChargeArray makeGrid(int N, int M, double xDistance, double yDistance, double q);
+
+    /**
+     * @brief Builds the grid of makeGrid with every page first touched by the thread that will read it.
+     *
+     * The arrays are allocated without being written, then OpenMP thread w fills charges
+     * [size * w / numThreads, size * (w + 1) / numThreads). These are exactly the starting
+     * ranges ECE_RangeScheduler gives each worker of the single-point direct sum, so on a
+     * multi-socket machine each thread mostly reads memory on its own NUMA node.
+     *
+     * @param N the number of rows in the grid
+     * @param M the number of columns in the grid
+     * @param xDistance the x distance between two adjacent points
+     * @param yDistance the y distance between two adjacent points
+     * @param q the common charge on each point
+     * @param numThreads number of OpenMP threads of the solver that will use the grid
+     * @return the charge collection
+     */
+    static ECE_ChargeArray makeGridFirstTouch(int N, int M, double xDistance, double yDistance, double q,
+                                              int numThreads);
+
+    /**
+     * @brief Builds rows [rowBegin, rowEnd) of the grid of makeGrid.
+     *
+     * Lets a process of a distributed run build only its own share of a grid too large for one node.
+     *
+     * @param N the number of rows in the full grid
+     * @param M the number of columns in the grid
+     * @param xDistance the x distance between two adjacent points
+     * @param yDistance the y distance between two adjacent points
+     * @param q the common charge on each point
+     * @param rowBegin first row to build
+     * @param rowEnd one past the last row to build
+     * @return the charge collection
+     */
+    static ECE_ChargeArray makeGridRows(int N, int M, double xDistance, double yDistance, double q,
+                                        int rowBegin, int rowEnd);
+};
+
+template<typename Generator>
+ECE_ChargeArray ECE_ChargeArray::generate(std::size_t count, int numThreads, Generator generator)
+{
+    ECE_ChargeArray charges;
+    charges.x.resize(count);
+    charges.y.resize(count);
+    charges.z.resize(count);
+    charges.q.resize(count);
+    double x0, y0, z0, q0 = 0;
+    if (count > 0)
+    {
+        generator(std::size_t(0), x0, y0, z0, q0);
+    }
+    bool planar = true, uniform = true;
+#pragma omp parallel num_threads(numThreads) reduction(&&:planar, uniform)
+    {
+        std::size_t workers = omp_get_num_threads(), worker = omp_get_thread_num();
+        for (std::size_t k = count * worker / workers; k < count * (worker + 1) / workers; k++)
+        {
+            generator(k, charges.x[k], charges.y[k], charges.z[k], charges.q[k]);
+            planar = planar && charges.z[k] == 0;
+            uniform = uniform && charges.q[k] == q0;
+        }
+    }
+    charges.planar = planar;
+    charges.uniform = uniform;
+    return charges;
+}
+
+
+#endif //LAB2_ECE_CHARGEARRAY_H
@@ -0,0 +1,368 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Implementation of loading charge sets from files and procedural generators
+ * */
+
+#include "ECE_ChargeLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char CHARGE_FILE_MAGIC[8] = {'E', 'C', 'H', 'A', 'R', 'G', 'E', '1'};
+
+    /**
+     * @brief Maps a whole file read-only.
+     *
+     * @param path the file to map
+     * @param length the size of the file
+     * @param error the reason the file could not be mapped, if any
+     * @return owner of the mapping, unmapping it when the last copy is gone; empty on failure
+     */
+    std::shared_ptr<const void> mapFile(const std::string &path, std::size_t &length, std::string &error)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat status{};
+        if (fd < 0 || fstat(fd, &status) != 0)
+        {
+            error = "cannot open " + path;
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return nullptr;
+        }
+        length = status.st_size;
+        if (length == 0)
+        {
+            close(fd);
+            error = path + " is empty";
+            return nullptr;
+        }
+        void *address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+        {
+            error = "cannot map " + path;
+            return nullptr;
+        }
+        return std::shared_ptr<const void>(address, [length](const void *mapped) {
+            munmap(const_cast<void *>(mapped), length);
+        });
+    }
+
+    /**
+     * @brief Maps 64 bits to 64 well mixed bits, the finalizer of SplitMix64.
+     */
+    std::uint64_t mix(std::uint64_t value)
+    {
+        value += 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    /**
+     * @brief A uniform number in [0, 1) drawn from the hash of seed and index.
+     */
+    double uniformAt(std::uint64_t seed, std::uint64_t index)
+    {
+        return static_cast<double>(mix(seed ^ mix(index)) >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * @brief Parses the comma separated numbers of one CSV line.
+     *
+     * @param begin the first character of the line
+     * @param end one past the last character, excluding the newline
+     * @param values the four parsed values
+     * @return true if the line holds exactly four numbers
+     */
+    bool parseCsvLine(const char *begin, const char *end, double values[4])
+    {
+        const char *p = begin;
+        for (int field = 0; field < 4; field++)
+        {
+            while (p < end && (*p == ' ' || *p == '\t'))
+            {
+                p++;
+            }
+            if (p < end && *p == '+')
+            {
+                p++;
+            }
+            std::from_chars_result result = std::from_chars(p, end, values[field]);
+            if (result.ec != std::errc())
+            {
+                return false;
+            }
+            p = result.ptr;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+            {
+                p++;
+            }
+            if (field < 3 && (p == end || *p++ != ','))
+            {
+                return false;
+            }
+        }
+        return p == end;
+    }
+}
+
+bool saveChargeFile(const std::string &path, const ECE_ChargeArray &charges)
+{
+    ChargeFileHeader header{};
+    std::memcpy(header.magic, CHARGE_FILE_MAGIC, sizeof(header.magic));
+    header.count = charges.size();
+    header.stride = (charges.size() + CHARGE_FILE_LANES - 1) / CHARGE_FILE_LANES * CHARGE_FILE_LANES;
+    header.planar = charges.isPlanar();
+    header.uniform = charges.hasUniformCharge();
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    const double *arrays[] = {charges.xData(), charges.yData(), charges.zData(), charges.qData()};
+    const double padding[CHARGE_FILE_LANES] = {};
+    for (const double *array: arrays)
+    {
+        written = written && std::fwrite(array, sizeof(double), header.count, file) == header.count;
+        std::size_t pad = header.stride - header.count;
+        written = written && std::fwrite(padding, sizeof(double), pad, file) == pad;
+    }
+    return std::fclose(file) == 0 && written;
+}
+
+bool mapChargeFile(const std::string &path, ECE_ChargeArray &charges, std::string &error, int numThreads)
+{
+    std::size_t length = 0;
+    std::shared_ptr<const void> mapping = mapFile(path, length, error);
+    if (!mapping)
+    {
+        return false;
+    }
+    ChargeFileHeader header{};
+    if (length >= sizeof(header))
+    {
+        std::memcpy(&header, mapping.get(), sizeof(header));
+    }
+    if (length < sizeof(header) || std::memcmp(header.magic, CHARGE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.stride < header.count || header.stride % CHARGE_FILE_LANES != 0 ||
+        header.stride > (length - sizeof(header)) / (4 * sizeof(double)))
+    {
+        error = path + " is not a valid charge file";
+        return false;
+    }
+    const double *arrays = reinterpret_cast<const double *>(static_cast<const char *>(mapping.get()) + sizeof(header));
+    std::size_t count = header.count, stride = header.stride;
+
+    // Fault in the pages with the first-touch schedule, several threads keep several reads in flight.
+    // The planar and uniform flags of the header select kernels that assume them for every charge,
+    // so a flag is only kept if the z or q column confirms it.
+    const std::size_t pageEntries = sysconf(_SC_PAGESIZE) / sizeof(double);
+    const double *z = arrays + 2 * stride, *q = arrays + 3 * stride;
+    const bool checkPlanar = header.planar != 0, checkUniform = header.uniform != 0 && count > 0;
+    bool planar = checkPlanar, uniform = checkUniform;
+    double touched = 0;
+#pragma omp parallel num_threads(numThreads) reduction(+:touched) reduction(&&:planar, uniform)
+    {
+        std::size_t workers = omp_get_num_threads(), worker = omp_get_thread_num();
+        std::size_t begin = count * worker / workers, end = count * (worker + 1) / workers;
+        for (int array = 0; array < 4; array++)
+        {
+            const double *values = arrays + array * stride;
+            for (std::size_t k = begin; k < end; k += pageEntries)
+            {
+                touched += values[k];
+            }
+        }
+        for (std::size_t k = begin; checkPlanar && planar && k < end; k++)
+        {
+            planar = z[k] == 0;
+        }
+        for (std::size_t k = begin; checkUniform && uniform && k < end; k++)
+        {
+            uniform = q[k] == q[0];
+        }
+    }
+    static_cast<void>(touched);
+
+    charges = ECE_ChargeArray::borrow(std::move(mapping), arrays, arrays + stride, z, q, count, planar, uniform);
+    return true;
+}
+
+bool loadChargeCsv(const std::string &path, ECE_ChargeArray &charges, std::string &error, int numThreads)
+{
+    std::size_t length = 0;
+    std::shared_ptr<const void> mapping = mapFile(path, length, error);
+    if (!mapping)
+    {
+        return false;
+    }
+    const char *text = static_cast<const char *>(mapping.get());
+
+    // every thread parses the lines starting in its byte range into its own buffers
+    std::vector<std::vector<double>> parsed(numThreads);
+    std::vector<std::string> errors(numThreads);
+#pragma omp parallel num_threads(numThreads)
+    {
+        std::size_t workers = omp_get_num_threads(), worker = omp_get_thread_num();
+        const char *end = text + length;
+        const char *begin = text + length * worker / workers;
+        const char *last = text + length * (worker + 1) / workers;
+        // a line belongs to the range its first character is in
+        if (worker > 0)
+        {
+            begin = std::find(begin - 1, end, '\n');
+            begin = begin == end ? end : begin + 1;
+        }
+        std::vector<double> &values = parsed[worker];
+        while (begin < last && begin < end)
+        {
+            const char *lineEnd = std::find(begin, end, '\n');
+            const char *first = begin;
+            while (first < lineEnd && std::isspace(static_cast<unsigned char>(*first)))
+            {
+                first++;
+            }
+            double charge[4];
+            if (first == lineEnd || *first == '#' || std::isalpha(static_cast<unsigned char>(*first)))
+            {
+                // blank line, comment or header
+            }
+            else if (parseCsvLine(first, lineEnd, charge))
+            {
+                values.insert(values.end(), charge, charge + 4);
+            }
+            else if (errors[worker].empty())
+            {
+                errors[worker] = "malformed line in " + path + ": " + std::string(begin, lineEnd);
+            }
+            begin = lineEnd == end ? end : lineEnd + 1;
+        }
+    }
+    for (const std::string &message: errors)
+    {
+        if (!message.empty())
+        {
+            error = message;
+            return false;
+        }
+    }
+
+    // copy the buffers into place, charge k comes from the buffer of the range it was parsed in
+    std::vector<std::size_t> offsets(numThreads + 1, 0);
+    for (int worker = 0; worker < numThreads; worker++)
+    {
+        offsets[worker + 1] = offsets[worker] + parsed[worker].size() / 4;
+    }
+    charges = ECE_ChargeArray::generate(offsets.back(), numThreads,
+                                        [&](std::size_t k, double &x, double &y, double &z, double &q) {
+                                            std::size_t worker = std::upper_bound(offsets.begin(), offsets.end(), k) -
+                                                                 offsets.begin() - 1;
+                                            const double *charge = &parsed[worker][(k - offsets[worker]) * 4];
+                                            x = charge[0];
+                                            y = charge[1];
+                                            z = charge[2];
+                                            q = charge[3];
+                                        });
+    return true;
+}
+
+ECE_ChargeArray makeLattice(std::size_t nx, std::size_t ny, std::size_t nz, const FieldPoint &spacing, double q,
+                            int numThreads)
+{
+    return ECE_ChargeArray::generate(nx * ny * nz, numThreads,
+                                     [=](std::size_t k, double &x, double &y, double &z, double &charge) {
+                                         x = spacing.x * (static_cast<double>(k % nx) - (nx - 1) / 2.0);
+                                         y = spacing.y * (static_cast<double>(k / nx % ny) - (ny - 1) / 2.0);
+                                         z = spacing.z * (static_cast<double>(k / nx / ny) - (nz - 1) / 2.0);
+                                         charge = q;
+                                     });
+}
+
+ECE_ChargeArray makeRandomCloud(std::size_t count, double radius, double q, std::uint64_t seed, int numThreads)
+{
+    return ECE_ChargeArray::generate(count, numThreads,
+                                     [=](std::size_t k, double &x, double &y, double &z, double &charge) {
+                                         // inverse transform sampling of the radius, uniform direction
+                                         double r = radius * std::cbrt(uniformAt(seed, 3 * k));
+                                         double cosTheta = 2 * uniformAt(seed, 3 * k + 1) - 1;
+                                         double sinTheta = std::sqrt(1 - cosTheta * cosTheta);
+                                         double phi = 2 * M_PI * uniformAt(seed, 3 * k + 2);
+                                         x = r * sinTheta * std::cos(phi);
+                                         y = r * sinTheta * std::sin(phi);
+                                         z = r * cosTheta;
+                                         charge = q;
+                                     });
+}
+
+ECE_ChargeArray makeLine(std::size_t count, const FieldPoint &from, const FieldPoint &to, double q, int numThreads)
+{
+    double steps = count > 1 ? static_cast<double>(count - 1) : 1;
+    return ECE_ChargeArray::generate(count, numThreads,
+                                     [=](std::size_t k, double &x, double &y, double &z, double &charge) {
+                                         double t = k / steps;
+                                         x = from.x + t * (to.x - from.x);
+                                         y = from.y + t * (to.y - from.y);
+                                         z = from.z + t * (to.z - from.z);
+                                         charge = q;
+                                     });
+}
+
+bool generateCharges(const std::string &spec, ECE_ChargeArray &charges, std::string &error, int numThreads)
+{
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream stream(spec);
+    while (std::getline(stream, field, ','))
+    {
+        fields.push_back(field);
+    }
+    try
+    {
+        const std::string kind = fields.empty() ? "" : fields[0];
+        if (kind == "lattice" && fields.size() == 8 && std::stoll(fields[1]) > 0 && std::stoll(fields[2]) > 0 &&
+            std::stoll(fields[3]) > 0)
+        {
+            charges = makeLattice(std::stoull(fields[1]), std::stoull(fields[2]), std::stoull(fields[3]),
+                                  {std::stod(fields[4]), std::stod(fields[5]), std::stod(fields[6])},
+                                  std::stod(fields[7]) * 1e-6, numThreads);
+            return true;
+        }
+        if (kind == "cloud" && fields.size() == 5 && std::stoll(fields[1]) > 0)
+        {
+            charges = makeRandomCloud(std::stoull(fields[1]), std::stod(fields[2]), std::stod(fields[3]) * 1e-6,
+                                      std::stoull(fields[4]), numThreads);
+            return true;
+        }
+        if (kind == "line" && fields.size() == 9 && std::stoll(fields[1]) > 0)
+        {
+            charges = makeLine(std::stoull(fields[1]), {std::stod(fields[2]), std::stod(fields[3]),
+                                                        std::stod(fields[4])},
+                               {std::stod(fields[5]), std::stod(fields[6]), std::stod(fields[7])},
+                               std::stod(fields[8]) * 1e-6, numThreads);
+            return true;
+        }
+    }
+    catch (const std::logic_error &)
+    {
+    }
+    error = "invalid generator " + spec;
+    return false;
+}
@@ -0,0 +1,132 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for loading charge sets from files and procedural generators
+ * */
+
+#ifndef LAB2_ECE_CHARGELOADER_H
+#define LAB2_ECE_CHARGELOADER_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const std::size_t CHARGE_FILE_LANES = CHARGE_ALIGNMENT / sizeof(double); // arrays are padded to whole cache lines
+
+/**
+ * @brief The header of a binary charge file.
+ *
+ * It is followed by the x, y, z and q arrays as little-endian doubles in SI units, each
+ * padded with zeros to stride entries. The header and the stride are whole cache lines, so
+ * a mapped file keeps every array aligned for the SIMD kernels.
+ */
+struct ChargeFileHeader
+{
+    char magic[8];            // "ECHARGE1"
+    std::uint64_t count;      // number of charges
+    std::uint64_t stride;     // entries per array including padding, a multiple of CHARGE_FILE_LANES
+    std::uint32_t planar;     // 1 if every charge has z = 0
+    std::uint32_t uniform;    // 1 if every charge has the same value
+    char reserved[32];        // zero, pads the header to one cache line
+};
+
+/**
+ * @brief Writes a charge collection to a binary charge file.
+ *
+ * @param path the file to create
+ * @param charges the charge collection
+ * @return false if the file could not be created or written
+ */
+bool saveChargeFile(const std::string &path, const ECE_ChargeArray &charges);
+
+/**
+ * @brief Maps a binary charge file into memory without copying it.
+ *
+ * The collection borrows the mapped arrays, so the kernels read the page cache directly and
+ * the mapping lives as long as any copy of the collection. The pages are faulted in by an
+ * OpenMP team with the schedule of ECE_ChargeArray::generate, which reads a cold file in parallel.
+ * The same pass checks the planar and uniform flags of the header and clears any the data contradicts.
+ *
+ * @param path the file to map
+ * @param charges the loaded charge collection
+ * @param error the reason the file could not be loaded, if any
+ * @param numThreads number of OpenMP threads faulting in the pages
+ * @return true if the file was mapped
+ */
+bool mapChargeFile(const std::string &path, ECE_ChargeArray &charges, std::string &error, int numThreads);
+
+/**
+ * @brief Parses a CSV file with one "x,y,z,q" line per charge in SI units.
+ *
+ * The file is mapped and split into one byte range per thread at line boundaries, every
+ * thread parses its range with std::from_chars. Empty lines, lines starting with '#' and a
+ * header line starting with a letter are skipped.
+ *
+ * @param path the file to read
+ * @param charges the loaded charge collection
+ * @param error the reason the file could not be loaded, if any
+ * @param numThreads number of OpenMP threads parsing the file
+ * @return true if every line was parsed
+ */
+bool loadChargeCsv(const std::string &path, ECE_ChargeArray &charges, std::string &error, int numThreads);
+
+/**
+ * @brief Builds a 3D lattice of nx * ny * nz equal charges centered at the origin.
+ *
+ * @param nx number of charges along x
+ * @param ny number of charges along y
+ * @param nz number of charges along z
+ * @param spacing distance between adjacent charges along x, y and z respectively
+ * @param q the charge on each point
+ * @param numThreads number of OpenMP threads
+ * @return the charge collection
+ */
+ECE_ChargeArray makeLattice(std::size_t nx, std::size_t ny, std::size_t nz, const FieldPoint &spacing, double q,
+                            int numThreads);
+
+/**
+ * @brief Scatters equal charges uniformly in a ball centered at the origin.
+ *
+ * Every charge is drawn from a hash of the seed and its index, so the cloud does not depend
+ * on the number of threads.
+ *
+ * @param count number of charges
+ * @param radius radius of the ball
+ * @param q the charge on each point
+ * @param seed seed of the generator
+ * @param numThreads number of OpenMP threads
+ * @return the charge collection
+ */
+ECE_ChargeArray makeRandomCloud(std::size_t count, double radius, double q, std::uint64_t seed, int numThreads);
+
+/**
+ * @brief Spaces equal charges evenly on a line segment, both ends included.
+ *
+ * @param count number of charges
+ * @param from the first end of the segment
+ * @param to the second end of the segment
+ * @param q the charge on each point
+ * @param numThreads number of OpenMP threads
+ * @return the charge collection
+ */
+ECE_ChargeArray makeLine(std::size_t count, const FieldPoint &from, const FieldPoint &to, double q, int numThreads);
+
+/**
+ * @brief Runs the generator described by a comma separated specification.
+ *
+ * Accepts "lattice,nx,ny,nz,dx,dy,dz,q", "cloud,count,radius,q,seed" and
+ * "line,count,x0,y0,z0,x1,y1,z1,q", with q in micro C like the -charge option.
+ *
+ * @param spec the specification
+ * @param charges the generated charge collection
+ * @param error the reason the specification was rejected, if any
+ * @param numThreads number of OpenMP threads
+ * @return true if the specification was valid
+ */
+bool generateCharges(const std::string &spec, ECE_ChargeArray &charges, std::string &error, int numThreads);
+
+
+#endif //LAB2_ECE_CHARGELOADER_H
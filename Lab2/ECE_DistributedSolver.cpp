@@ -0,0 +1,76 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the hybrid MPI + OpenMP field solver spreading a grid over processes
+ * */
+
+#include "ECE_DistributedSolver.h"
+#include <algorithm>
+#include <climits>
+
+// largest number of doubles passed to one MPI call, counts are ints
+const std::size_t MPI_CHUNK = static_cast<std::size_t>(INT_MAX) / 3 * 3;
+
+ECE_DistributedSolver::ECE_DistributedSolver(MPI_Comm comm, PartitionMode mode, int N, int M, double xDistance,
+                                             double yDistance, double q, int numThreads)
+        : comm(comm), mode(mode)
+{
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (mode == PartitionMode::Charges)
+    {
+        // whole rows per process, so no process ever builds the full grid
+        int rowBegin = static_cast<int>(static_cast<long long>(N) * rank / size);
+        int rowEnd = static_cast<int>(static_cast<long long>(N) * (rank + 1) / size);
+        charges = ECE_ChargeArray::makeGridRows(N, M, xDistance, yDistance, q, rowBegin, rowEnd);
+    }
+    else
+    {
+        charges = ECE_ChargeArray::makeGrid(N, M, xDistance, yDistance, q);
+    }
+    solver = std::make_unique<ECE_FieldSolver>(charges, numThreads);
+}
+
+void ECE_DistributedSolver::computeFields(const std::vector<FieldPoint> &targets,
+                                          std::vector<FieldVector> &fields) const
+{
+    static_assert(sizeof(FieldVector) == 3 * sizeof(double), "FieldVector is sent as three doubles");
+    if (mode == PartitionMode::Charges)
+    {
+        // partial fields of the local rows, summed over the processes in place
+        solver->computeFields(targets, fields);
+        double *data = reinterpret_cast<double *>(fields.data());
+        std::size_t count = 3 * fields.size();
+        for (std::size_t offset = 0; offset < count; offset += MPI_CHUNK)
+        {
+            int chunk = static_cast<int>(std::min(MPI_CHUNK, count - offset));
+            MPI_Allreduce(MPI_IN_PLACE, data + offset, chunk, MPI_DOUBLE, MPI_SUM, comm);
+        }
+        return;
+    }
+
+    // contiguous share of the targets per process, the shares are then gathered everywhere
+    std::vector<int> counts(size), displacements(size);
+    for (int r = 0; r < size; r++)
+    {
+        std::size_t first = targets.size() * r / size;
+        std::size_t last = targets.size() * (r + 1) / size;
+        counts[r] = static_cast<int>(3 * (last - first));
+        displacements[r] = static_cast<int>(3 * first);
+    }
+    std::size_t first = targets.size() * rank / size;
+    std::size_t last = targets.size() * (rank + 1) / size;
+    std::vector<FieldPoint> share(targets.begin() + first, targets.begin() + last);
+    std::vector<FieldVector> shareFields;
+    solver->computeFields(share, shareFields);
+
+    fields.resize(targets.size());
+    MPI_Allgatherv(shareFields.data(), counts[rank], MPI_DOUBLE, fields.data(), counts.data(),
+                   displacements.data(), MPI_DOUBLE, comm);
+}
+
+std::size_t ECE_DistributedSolver::localChargeCount() const
+{
+    return charges.size();
+}
@@ -0,0 +1,76 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the hybrid MPI + OpenMP field solver spreading a grid over processes
+ * */
+
+#ifndef LAB2_ECE_DISTRIBUTEDSOLVER_H
+#define LAB2_ECE_DISTRIBUTEDSOLVER_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <memory>
+#include <vector>
+#include <mpi.h>
+
+/**
+ * @brief How the work of a batch is divided between the processes.
+ */
+enum class PartitionMode
+{
+    Charges, // every process holds a slab of grid rows and sums it at every target, then MPI_Allreduce
+    Targets  // every process holds the whole grid and sums it at its share of targets, then MPI_Allgatherv
+};
+
+/**
+ * @brief Evaluates the field of the lab's N x M grid with several MPI processes, each using OpenMP.
+ *
+ * Partitioning the charges keeps the memory per process at N * M / size charges, which is what
+ * makes 10^9-charge grids fit on a small cluster. Partitioning the targets needs no reduction of
+ * partial fields and suits grids that fit on every node. Either way every process must call
+ * computeFields with the same targets, and every process receives all fields.
+ */
+class ECE_DistributedSolver
+{
+protected:
+    MPI_Comm comm;                          // the communicator of the participating processes
+    int rank;                               // index of this process in comm
+    int size;                               // number of processes in comm
+    PartitionMode mode;                     // how a batch is divided
+    ECE_ChargeArray charges;                // this process's charges, the whole grid in target mode
+    std::unique_ptr<ECE_FieldSolver> solver; // OpenMP solver over the local charges
+public:
+    /**
+     * @brief Constructor for ECE_DistributedSolver, collective over comm.
+     *
+     * @param comm the communicator of the participating processes
+     * @param mode how a batch is divided
+     * @param N the number of rows in the grid
+     * @param M the number of columns in the grid
+     * @param xDistance the x distance between two adjacent points
+     * @param yDistance the y distance between two adjacent points
+     * @param q the common charge on each point
+     * @param numThreads number of OpenMP threads per process
+     */
+    ECE_DistributedSolver(MPI_Comm comm, PartitionMode mode, int N, int M, double xDistance, double yDistance,
+                          double q, int numThreads);
+
+    /**
+     * @brief Computes the electric field at a batch of points, collective over comm.
+     *
+     * @param targets the points to evaluate, identical on every process
+     * @param fields the electric field at each point, resized to match targets
+     */
+    void computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const;
+
+    /**
+     * @brief Getter for the number of charges held by this process.
+     *
+     * @return the local charge count
+     */
+    std::size_t localChargeCount() const;
+};
+
+
+#endif //LAB2_ECE_DISTRIBUTEDSOLVER_H
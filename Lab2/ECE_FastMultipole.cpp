@@ -0,0 +1,685 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the Cartesian fast multipole method evaluating electric fields
+ * */
+
+#include "ECE_FastMultipole.h"
+#include "ECE_ElectricField.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <omp.h>
+
+/**
+ * @brief Spreads the low 21 bits of v so that there are two zero bits between each of them.
+ */
+static std::uint64_t spreadBits(std::uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+/**
+ * @brief Inverse of spreadBits.
+ */
+static std::uint64_t compactBits(std::uint64_t v)
+{
+    v &= 0x1249249249249249;
+    v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3;
+    v = (v ^ (v >> 4)) & 0x100f00f00f00f00f;
+    v = (v ^ (v >> 8)) & 0x1f0000ff0000ff;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffff;
+    v = (v ^ (v >> 32)) & 0x1fffff;
+    return v;
+}
+
+static std::uint64_t mortonKey(std::uint64_t i, std::uint64_t j, std::uint64_t k)
+{
+    return spreadBits(i) | (spreadBits(j) << 1) | (spreadBits(k) << 2);
+}
+
+/**
+ * @brief Finds the position of key in a sorted key list.
+ *
+ * @return the position, or keys.size() if the box is not occupied
+ */
+static std::size_t findBox(const std::vector<std::uint64_t> &keys, std::uint64_t key)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    return (it != keys.end() && *it == key) ? static_cast<std::size_t>(it - keys.begin()) : keys.size();
+}
+
+ECE_FastMultipole::ECE_FastMultipole(const ECE_ChargeArray &charges, int order, int numThreads)
+        : charges(charges), order(std::max(order, 1)), numThreads(numThreads)
+{
+    int p = this->order;
+    indexTable.assign((p + 1) * (p + 1) * (p + 1), -1);
+    std::vector<double> factorial(p + 1, 1.0);
+    for (int n = 1; n <= p; n++)
+    {
+        factorial[n] = factorial[n - 1] * n;
+    }
+    for (int degree = 0; degree <= p; degree++)
+    {
+        for (int a = degree; a >= 0; a--)
+        {
+            for (int b = degree - a; b >= 0; b--)
+            {
+                int c = degree - a - b;
+                indexTable[(a * (p + 1) + b) * (p + 1) + c] = static_cast<int>(powX.size());
+                powX.push_back(a);
+                powY.push_back(b);
+                powZ.push_back(c);
+                inverseFactorial.push_back(1 / (factorial[a] * factorial[b] * factorial[c]));
+                sign.push_back(degree % 2 ? -1.0 : 1.0);
+            }
+        }
+        degreeCount.push_back(static_cast<int>(powX.size()));
+    }
+    coefficientCount = static_cast<int>(powX.size());
+
+    if (charges.size() > 0)
+    {
+        buildTree();
+        std::vector<Scratch> scratch = makeScratch();
+#pragma omp parallel num_threads(numThreads)
+#pragma omp single
+        upwardPass(scratch);
+    }
+}
+
+int ECE_FastMultipole::index(int a, int b, int c) const
+{
+    return indexTable[(a * (order + 1) + b) * (order + 1) + c];
+}
+
+int ECE_FastMultipole::getOrder() const
+{
+    return order;
+}
+
+void ECE_FastMultipole::boxCenter(int level, std::uint64_t key, double &cx, double &cy, double &cz) const
+{
+    double size = tree.rootSize / static_cast<double>(1u << level);
+    cx = tree.originX + (static_cast<double>(compactBits(key)) + 0.5) * size;
+    cy = tree.originY + (static_cast<double>(compactBits(key >> 1)) + 0.5) * size;
+    cz = tree.originZ + (static_cast<double>(compactBits(key >> 2)) + 0.5) * size;
+}
+
+void ECE_FastMultipole::derivatives(double X, double Y, double Z, double *R) const
+{
+    // McMurchie-Davidson recurrence for R^n_{tuv}, the derivatives of 1/r:
+    // R^n_{000} = (-1)^n (2n-1)!! / r^(2n+1) and
+    // R^n_{t+1,u,v} = t R^{n+1}_{t-1,u,v} + X R^{n+1}_{t,u,v}, likewise for u and v.
+    // D^{tuv}(1/r) = R^0_{tuv}, so the first coefficientCount entries of R are the result.
+    // Level n is stored at offset n * coefficientCount, R holds (order + 1) * coefficientCount.
+    int p = order;
+    double invR2 = 1 / (X * X + Y * Y + Z * Z);
+    double base = std::sqrt(invR2);
+    for (int n = 0; n <= p; n++)
+    {
+        R[n * coefficientCount] = base;
+        base *= -(2 * n + 1) * invR2;
+    }
+    for (int n = p - 1; n >= 0; n--)
+    {
+        double *current = &R[n * coefficientCount];
+        const double *next = &R[(n + 1) * coefficientCount];
+        for (int m = 1; m < degreeCount[p - n]; m++)
+        {
+            int t = powX[m], u = powY[m], v = powZ[m];
+            if (t > 0)
+            {
+                current[m] = X * next[index(t - 1, u, v)] + (t > 1 ? (t - 1) * next[index(t - 2, u, v)] : 0);
+            }
+            else if (u > 0)
+            {
+                current[m] = Y * next[index(t, u - 1, v)] + (u > 1 ? (u - 1) * next[index(t, u - 2, v)] : 0);
+            }
+            else
+            {
+                current[m] = Z * next[index(t, u, v - 1)] + (v > 1 ? (v - 1) * next[index(t, u, v - 2)] : 0);
+            }
+        }
+    }
+}
+
+std::uint64_t ECE_FastMultipole::cellKey(double x, double y, double z) const
+{
+    // Morton key at the finest resolution
+    const std::uint64_t cells = 1u << FMM_MAX_DEPTH;
+    auto cell = [&](double v, double origin) {
+        auto c = static_cast<std::uint64_t>((v - origin) / tree.rootSize * cells);
+        return std::min(c, cells - 1);
+    };
+    return mortonKey(cell(x, tree.originX), cell(y, tree.originY), cell(z, tree.originZ));
+}
+
+void ECE_FastMultipole::buildTree()
+{
+    std::size_t sourceCount = charges.size();
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+
+    // root cube enclosing the charges
+    double minX = HUGE_VAL, minY = HUGE_VAL, minZ = HUGE_VAL;
+    double maxX = -HUGE_VAL, maxY = -HUGE_VAL, maxZ = -HUGE_VAL;
+#pragma omp parallel for reduction(min:minX, minY, minZ) reduction(max:maxX, maxY, maxZ) num_threads(numThreads)
+    for (std::size_t i = 0; i < sourceCount; i++)
+    {
+        minX = std::min(minX, xs[i]);
+        minY = std::min(minY, ys[i]);
+        minZ = std::min(minZ, zs[i]);
+        maxX = std::max(maxX, xs[i]);
+        maxY = std::max(maxY, ys[i]);
+        maxZ = std::max(maxZ, zs[i]);
+    }
+    double extent = std::max({maxX - minX, maxY - minY, maxZ - minZ});
+    tree.rootSize = extent > 0 ? extent * (1 + 1e-9) : 1.0;
+    tree.originX = (minX + maxX - tree.rootSize) / 2;
+    tree.originY = (minY + maxY - tree.rootSize) / 2;
+    tree.originZ = (minZ + maxZ - tree.rootSize) / 2;
+
+    std::vector<std::uint64_t> sourceKeys(sourceCount);
+#pragma omp parallel for num_threads(numThreads)
+    for (std::size_t i = 0; i < sourceCount; i++)
+    {
+        sourceKeys[i] = cellKey(xs[i], ys[i], zs[i]);
+    }
+    std::vector<std::size_t> sourceOrder(sourceCount);
+    std::iota(sourceOrder.begin(), sourceOrder.end(), 0);
+    std::sort(sourceOrder.begin(), sourceOrder.end(),
+              [&](std::size_t a, std::size_t b) { return sourceKeys[a] < sourceKeys[b]; });
+
+    // shallowest depth whose occupied leaves hold FMM_LEAF_SIZE charges on average
+    tree.depth = 2;
+    for (; tree.depth < FMM_MAX_DEPTH; tree.depth++)
+    {
+        int shift = 3 * (FMM_MAX_DEPTH - tree.depth);
+        std::size_t occupied = 0;
+        for (std::size_t i = 0; i < sourceCount; i++)
+        {
+            if (i == 0 || (sourceKeys[sourceOrder[i]] >> shift) != (sourceKeys[sourceOrder[i - 1]] >> shift))
+            {
+                occupied++;
+            }
+        }
+        if (sourceCount <= FMM_LEAF_SIZE * occupied)
+        {
+            break;
+        }
+    }
+
+    tree.sx.resize(sourceCount);
+    tree.sy.resize(sourceCount);
+    tree.sz.resize(sourceCount);
+    tree.sq.resize(sourceCount);
+#pragma omp parallel for num_threads(numThreads)
+    for (std::size_t i = 0; i < sourceCount; i++)
+    {
+        std::size_t c = sourceOrder[i];
+        tree.sx[i] = xs[c];
+        tree.sy[i] = ys[c];
+        tree.sz[i] = zs[c];
+        tree.sq[i] = qs[c];
+    }
+
+    // occupied boxes of every level, the leaves also record their ranges
+    int leafShift = 3 * (FMM_MAX_DEPTH - tree.depth);
+    tree.sources.assign(tree.depth + 1, Level());
+    tree.sourceStart.clear();
+    for (std::size_t i = 0; i < sourceCount; i++)
+    {
+        std::uint64_t key = sourceKeys[sourceOrder[i]] >> leafShift;
+        if (tree.sources[tree.depth].keys.empty() || tree.sources[tree.depth].keys.back() != key)
+        {
+            tree.sources[tree.depth].keys.push_back(key);
+            tree.sourceStart.push_back(i);
+        }
+    }
+    tree.sourceStart.push_back(sourceCount);
+    for (int level = tree.depth - 1; level >= 2; level--)
+    {
+        std::vector<std::uint64_t> &parents = tree.sources[level].keys;
+        for (std::uint64_t key: tree.sources[level + 1].keys)
+        {
+            if (parents.empty() || parents.back() != (key >> 3))
+            {
+                parents.push_back(key >> 3);
+            }
+        }
+    }
+    for (int level = 2; level <= tree.depth; level++)
+    {
+        tree.sources[level].coefficients.assign(tree.sources[level].keys.size() * coefficientCount, 0);
+    }
+}
+
+void ECE_FastMultipole::buildTargets(TargetTree &targetTree, const std::vector<FieldPoint> &targets) const
+{
+    // targets outside the root cube have no box, they are evaluated by evaluateOutside
+    std::vector<std::uint64_t> targetKeys(targets.size());
+    targetTree.targetOrder.clear();
+    targetTree.outside.clear();
+    for (std::size_t t = 0; t < targets.size(); t++)
+    {
+        double x = targets[t].x - tree.originX;
+        double y = targets[t].y - tree.originY;
+        double z = targets[t].z - tree.originZ;
+        if (x >= 0 && y >= 0 && z >= 0 && x < tree.rootSize && y < tree.rootSize && z < tree.rootSize)
+        {
+            targetKeys[t] = cellKey(targets[t].x, targets[t].y, targets[t].z);
+            targetTree.targetOrder.push_back(t);
+        }
+        else
+        {
+            targetTree.outside.push_back(t);
+        }
+    }
+    std::sort(targetTree.targetOrder.begin(), targetTree.targetOrder.end(),
+              [&](std::size_t a, std::size_t b) { return targetKeys[a] < targetKeys[b]; });
+
+    int leafShift = 3 * (FMM_MAX_DEPTH - tree.depth);
+    targetTree.targets.assign(tree.depth + 1, Level());
+    targetTree.targetStart.clear();
+    for (std::size_t t = 0; t < targetTree.targetOrder.size(); t++)
+    {
+        std::uint64_t key = targetKeys[targetTree.targetOrder[t]] >> leafShift;
+        if (targetTree.targets[tree.depth].keys.empty() || targetTree.targets[tree.depth].keys.back() != key)
+        {
+            targetTree.targets[tree.depth].keys.push_back(key);
+            targetTree.targetStart.push_back(t);
+        }
+    }
+    targetTree.targetStart.push_back(targetTree.targetOrder.size());
+    for (int level = tree.depth - 1; level >= 2; level--)
+    {
+        std::vector<std::uint64_t> &parents = targetTree.targets[level].keys;
+        for (std::uint64_t key: targetTree.targets[level + 1].keys)
+        {
+            if (parents.empty() || parents.back() != (key >> 3))
+            {
+                parents.push_back(key >> 3);
+            }
+        }
+    }
+    for (int level = 2; level <= tree.depth; level++)
+    {
+        targetTree.targets[level].coefficients.assign(targetTree.targets[level].keys.size() * coefficientCount, 0);
+    }
+}
+
+std::vector<ECE_FastMultipole::Scratch> ECE_FastMultipole::makeScratch() const
+{
+    // one per thread of the team, a taskloop body runs on one thread without yielding
+    std::vector<Scratch> scratch(std::max(numThreads, 1));
+    for (Scratch &s: scratch)
+    {
+        s.px.resize(order + 1);
+        s.py.resize(order + 1);
+        s.pz.resize(order + 1);
+        s.R.resize((order + 1) * coefficientCount);
+        s.neighbours.reserve(27);
+    }
+    return scratch;
+}
+
+void ECE_FastMultipole::upwardPass(std::vector<Scratch> &scratch)
+{
+    int p = order;
+
+    // P2M: M_alpha = sum of q s^alpha / alpha! about the leaf center
+    Level &leaves = tree.sources[tree.depth];
+#pragma omp taskloop grainsize(16) shared(leaves, scratch, p)
+    for (std::size_t box = 0; box < leaves.keys.size(); box++)
+    {
+        double cx, cy, cz;
+        boxCenter(tree.depth, leaves.keys[box], cx, cy, cz);
+        double *M = &leaves.coefficients[box * coefficientCount];
+        Scratch &work = scratch[omp_get_thread_num()];
+        double *px = work.px.data(), *py = work.py.data(), *pz = work.pz.data();
+        for (std::size_t i = tree.sourceStart[box]; i < tree.sourceStart[box + 1]; i++)
+        {
+            px[0] = py[0] = pz[0] = 1;
+            for (int n = 1; n <= p; n++)
+            {
+                px[n] = px[n - 1] * (tree.sx[i] - cx);
+                py[n] = py[n - 1] * (tree.sy[i] - cy);
+                pz[n] = pz[n - 1] * (tree.sz[i] - cz);
+            }
+            for (int m = 0; m < coefficientCount; m++)
+            {
+                M[m] += tree.sq[i] * px[powX[m]] * py[powY[m]] * pz[powZ[m]];
+            }
+        }
+        for (int m = 0; m < coefficientCount; m++)
+        {
+            M[m] *= inverseFactorial[m];
+        }
+    }
+
+    // M2M: M_alpha(parent) += sum over beta <= alpha of M_beta(child) delta^(alpha-beta) / (alpha-beta)!
+    for (int level = tree.depth - 1; level >= 2; level--)
+    {
+        Level &parents = tree.sources[level];
+        const Level &children = tree.sources[level + 1];
+#pragma omp taskloop grainsize(16) shared(parents, children, scratch, p, level)
+        for (std::size_t box = 0; box < parents.keys.size(); box++)
+        {
+            double cx, cy, cz;
+            boxCenter(level, parents.keys[box], cx, cy, cz);
+            double *M = &parents.coefficients[box * coefficientCount];
+            auto first = std::lower_bound(children.keys.begin(), children.keys.end(), parents.keys[box] << 3);
+            Scratch &work = scratch[omp_get_thread_num()];
+            double *ex = work.px.data(), *ey = work.py.data(), *ez = work.pz.data();
+            for (auto it = first; it != children.keys.end() && (*it >> 3) == parents.keys[box]; ++it)
+            {
+                double ccx, ccy, ccz;
+                boxCenter(level + 1, *it, ccx, ccy, ccz);
+                ex[0] = ey[0] = ez[0] = 1;
+                for (int n = 1; n <= p; n++)
+                {
+                    ex[n] = ex[n - 1] * (ccx - cx) / n;
+                    ey[n] = ey[n - 1] * (ccy - cy) / n;
+                    ez[n] = ez[n - 1] * (ccz - cz) / n;
+                }
+                const double *child = &children.coefficients[(it - children.keys.begin()) * coefficientCount];
+                for (int m = 0; m < coefficientCount; m++)
+                {
+                    double sum = 0;
+                    for (int a = 0; a <= powX[m]; a++)
+                    {
+                        for (int b = 0; b <= powY[m]; b++)
+                        {
+                            for (int c = 0; c <= powZ[m]; c++)
+                            {
+                                sum += child[index(a, b, c)] * ex[powX[m] - a] * ey[powY[m] - b] * ez[powZ[m] - c];
+                            }
+                        }
+                    }
+                    M[m] += sum;
+                }
+            }
+        }
+    }
+}
+
+void ECE_FastMultipole::downwardPass(TargetTree &targetTree, std::vector<Scratch> &scratch) const
+{
+    int p = order;
+    for (int level = 2; level <= tree.depth; level++)
+    {
+        Level &locals = targetTree.targets[level];
+        const Level &multipoles = tree.sources[level];
+        const std::int64_t boxesPerAxis = std::int64_t(1) << level;
+#pragma omp taskloop grainsize(4) shared(targetTree, locals, multipoles, scratch, p, level, boxesPerAxis)
+        for (std::size_t box = 0; box < locals.keys.size(); box++)
+        {
+            std::uint64_t key = locals.keys[box];
+            double cx, cy, cz;
+            boxCenter(level, key, cx, cy, cz);
+            double *L = &locals.coefficients[box * coefficientCount];
+            Scratch &work = scratch[omp_get_thread_num()];
+
+            // L2L: L'_gamma = sum over beta >= gamma of L_beta delta^(beta-gamma) / (beta-gamma)!
+            if (level > 2)
+            {
+                const Level &parents = targetTree.targets[level - 1];
+                const double *parent = &parents.coefficients[findBox(parents.keys, key >> 3) * coefficientCount];
+                double pcx, pcy, pcz;
+                boxCenter(level - 1, key >> 3, pcx, pcy, pcz);
+                double *ex = work.px.data(), *ey = work.py.data(), *ez = work.pz.data();
+                ex[0] = ey[0] = ez[0] = 1;
+                for (int n = 1; n <= p; n++)
+                {
+                    ex[n] = ex[n - 1] * (cx - pcx) / n;
+                    ey[n] = ey[n - 1] * (cy - pcy) / n;
+                    ez[n] = ez[n - 1] * (cz - pcz) / n;
+                }
+                for (int m = 0; m < coefficientCount; m++)
+                {
+                    double sum = 0;
+                    for (int n = m; n < coefficientCount; n++)
+                    {
+                        if (powX[n] >= powX[m] && powY[n] >= powY[m] && powZ[n] >= powZ[m])
+                        {
+                            sum += parent[n] * ex[powX[n] - powX[m]] * ey[powY[n] - powY[m]]
+                                   * ez[powZ[n] - powZ[m]];
+                        }
+                    }
+                    L[m] += sum;
+                }
+            }
+
+            // M2L over the interaction list: children of the parent's neighbours that are not our neighbours
+            auto i = static_cast<std::int64_t>(compactBits(key));
+            auto j = static_cast<std::int64_t>(compactBits(key >> 1));
+            auto k = static_cast<std::int64_t>(compactBits(key >> 2));
+            const double *D = work.R.data();
+            for (std::int64_t ni = (i / 2 - 1) * 2; ni < (i / 2 + 2) * 2; ni++)
+            {
+                for (std::int64_t nj = (j / 2 - 1) * 2; nj < (j / 2 + 2) * 2; nj++)
+                {
+                    for (std::int64_t nk = (k / 2 - 1) * 2; nk < (k / 2 + 2) * 2; nk++)
+                    {
+                        if (ni < 0 || nj < 0 || nk < 0 || ni >= boxesPerAxis || nj >= boxesPerAxis
+                            || nk >= boxesPerAxis)
+                        {
+                            continue;
+                        }
+                        if (std::abs(ni - i) <= 1 && std::abs(nj - j) <= 1 && std::abs(nk - k) <= 1)
+                        {
+                            continue;
+                        }
+                        std::size_t source = findBox(multipoles.keys, mortonKey(ni, nj, nk));
+                        if (source == multipoles.keys.size())
+                        {
+                            continue;
+                        }
+                        double scx, scy, scz;
+                        boxCenter(level, multipoles.keys[source], scx, scy, scz);
+                        derivatives(cx - scx, cy - scy, cz - scz, work.R.data());
+                        const double *M = &multipoles.coefficients[source * coefficientCount];
+                        for (int b = 0; b < coefficientCount; b++)
+                        {
+                            int degree = powX[b] + powY[b] + powZ[b];
+                            double sum = 0;
+                            for (int a = 0; a < degreeCount[p - degree]; a++)
+                            {
+                                sum += sign[a] * M[a] * D[index(powX[a] + powX[b], powY[a] + powY[b],
+                                                                powZ[a] + powZ[b])];
+                            }
+                            L[b] += sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ECE_FastMultipole::evaluateLeaves(const TargetTree &targetTree, const std::vector<FieldPoint> &targets,
+                                       std::vector<FieldVector> &fields, std::vector<Scratch> &scratch) const
+{
+    int p = order;
+    const Level &locals = targetTree.targets[tree.depth];
+    const Level &sources = tree.sources[tree.depth];
+    const std::int64_t boxesPerAxis = std::int64_t(1) << tree.depth;
+#pragma omp taskloop grainsize(4) shared(targetTree, targets, fields, locals, sources, scratch, p, boxesPerAxis)
+    for (std::size_t box = 0; box < locals.keys.size(); box++)
+    {
+        std::uint64_t key = locals.keys[box];
+        double cx, cy, cz;
+        boxCenter(tree.depth, key, cx, cy, cz);
+        const double *L = &locals.coefficients[box * coefficientCount];
+        Scratch &work = scratch[omp_get_thread_num()];
+
+        // neighbouring source leaves summed directly
+        std::vector<std::size_t> &neighbours = work.neighbours;
+        neighbours.clear();
+        auto i = static_cast<std::int64_t>(compactBits(key));
+        auto j = static_cast<std::int64_t>(compactBits(key >> 1));
+        auto k = static_cast<std::int64_t>(compactBits(key >> 2));
+        for (std::int64_t ni = i - 1; ni <= i + 1; ni++)
+        {
+            for (std::int64_t nj = j - 1; nj <= j + 1; nj++)
+            {
+                for (std::int64_t nk = k - 1; nk <= k + 1; nk++)
+                {
+                    if (ni >= 0 && nj >= 0 && nk >= 0 && ni < boxesPerAxis && nj < boxesPerAxis && nk < boxesPerAxis)
+                    {
+                        std::size_t source = findBox(sources.keys, mortonKey(ni, nj, nk));
+                        if (source != sources.keys.size())
+                        {
+                            neighbours.push_back(source);
+                        }
+                    }
+                }
+            }
+        }
+
+        double *px = work.px.data(), *py = work.py.data(), *pz = work.pz.data();
+        for (std::size_t t = targetTree.targetStart[box]; t < targetTree.targetStart[box + 1]; t++)
+        {
+            const FieldPoint &target = targets[targetTree.targetOrder[t]];
+
+            // L2P: grad phi = sum over gamma of L_{gamma + e} t^gamma / gamma!
+            px[0] = py[0] = pz[0] = 1;
+            for (int n = 1; n <= p; n++)
+            {
+                px[n] = px[n - 1] * (target.x - cx);
+                py[n] = py[n - 1] * (target.y - cy);
+                pz[n] = pz[n - 1] * (target.z - cz);
+            }
+            double gradX = 0, gradY = 0, gradZ = 0;
+            for (int m = 0; m < degreeCount[p - 1]; m++)
+            {
+                double term = px[powX[m]] * py[powY[m]] * pz[powZ[m]] * inverseFactorial[m];
+                gradX += L[index(powX[m] + 1, powY[m], powZ[m])] * term;
+                gradY += L[index(powX[m], powY[m] + 1, powZ[m])] * term;
+                gradZ += L[index(powX[m], powY[m], powZ[m] + 1)] * term;
+            }
+            double sumX = -gradX, sumY = -gradY, sumZ = -gradZ;
+
+            // P2P
+            for (std::size_t source: neighbours)
+            {
+                for (std::size_t s = tree.sourceStart[source]; s < tree.sourceStart[source + 1]; s++)
+                {
+                    double dx = target.x - tree.sx[s];
+                    double dy = target.y - tree.sy[s];
+                    double dz = target.z - tree.sz[s];
+                    double r2 = dx * dx + dy * dy + dz * dz;
+                    if (r2 > 0)
+                    {
+                        double w = tree.sq[s] / (r2 * std::sqrt(r2));
+                        sumX += dx * w;
+                        sumY += dy * w;
+                        sumZ += dz * w;
+                    }
+                }
+            }
+            fields[targetTree.targetOrder[t]] = {K * sumX, K * sumY, K * sumZ};
+        }
+    }
+}
+
+void ECE_FastMultipole::evaluateOutside(const TargetTree &targetTree, const std::vector<FieldPoint> &targets,
+                                        std::vector<FieldVector> &fields, std::vector<Scratch> &scratch) const
+{
+    int p = order;
+#pragma omp taskloop grainsize(4) shared(targetTree, targets, fields, scratch, p)
+    for (std::size_t o = 0; o < targetTree.outside.size(); o++)
+    {
+        const FieldPoint &target = targets[targetTree.outside[o]];
+        Scratch &work = scratch[omp_get_thread_num()];
+        std::vector<std::pair<int, std::size_t>> &boxes = work.boxes;
+        boxes.clear();
+        for (std::size_t box = 0; box < tree.sources[2].keys.size(); box++)
+        {
+            boxes.emplace_back(2, box);
+        }
+        double sumX = 0, sumY = 0, sumZ = 0;
+        while (!boxes.empty())
+        {
+            int level = boxes.back().first;
+            std::size_t box = boxes.back().second;
+            boxes.pop_back();
+            const Level &sources = tree.sources[level];
+            std::uint64_t key = sources.keys[box];
+            double cx, cy, cz;
+            boxCenter(level, key, cx, cy, cz);
+            double X = target.x - cx, Y = target.y - cy, Z = target.z - cz;
+            double size = tree.rootSize / static_cast<double>(1u << level);
+            // well separated like in M2L once the target lies outside the 3x3x3 boxes around this one
+            if (std::max({std::abs(X), std::abs(Y), std::abs(Z)}) > 1.5 * size)
+            {
+                // M2P, the separation of M2L: grad phi = sum over alpha of (-1)^|alpha| M_alpha D^{alpha + e}
+                const double *D = work.R.data();
+                derivatives(X, Y, Z, work.R.data());
+                const double *M = &sources.coefficients[box * coefficientCount];
+                for (int a = 0; a < degreeCount[p - 1]; a++)
+                {
+                    double weight = sign[a] * M[a];
+                    sumX -= weight * D[index(powX[a] + 1, powY[a], powZ[a])];
+                    sumY -= weight * D[index(powX[a], powY[a] + 1, powZ[a])];
+                    sumZ -= weight * D[index(powX[a], powY[a], powZ[a] + 1)];
+                }
+            }
+            else if (level == tree.depth)
+            {
+                for (std::size_t s = tree.sourceStart[box]; s < tree.sourceStart[box + 1]; s++)
+                {
+                    double dx = target.x - tree.sx[s];
+                    double dy = target.y - tree.sy[s];
+                    double dz = target.z - tree.sz[s];
+                    double r2 = dx * dx + dy * dy + dz * dz;
+                    double w = tree.sq[s] / (r2 * std::sqrt(r2));
+                    sumX += dx * w;
+                    sumY += dy * w;
+                    sumZ += dz * w;
+                }
+            }
+            else
+            {
+                const Level &children = tree.sources[level + 1];
+                auto first = std::lower_bound(children.keys.begin(), children.keys.end(), key << 3);
+                for (auto it = first; it != children.keys.end() && (*it >> 3) == key; ++it)
+                {
+                    boxes.emplace_back(level + 1, static_cast<std::size_t>(it - children.keys.begin()));
+                }
+            }
+        }
+        fields[targetTree.outside[o]] = {K * sumX, K * sumY, K * sumZ};
+    }
+}
+
+void ECE_FastMultipole::computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const
+{
+    fields.assign(targets.size(), {0, 0, 0});
+    if (targets.empty() || tree.sx.empty())
+    {
+        return;
+    }
+
+    TargetTree targetTree;
+    buildTargets(targetTree, targets);
+    std::vector<Scratch> scratch = makeScratch();
+
+#pragma omp parallel num_threads(numThreads)
+#pragma omp single
+    {
+        downwardPass(targetTree, scratch);
+        evaluateLeaves(targetTree, targets, fields, scratch);
+        evaluateOutside(targetTree, targets, fields, scratch);
+    }
+}
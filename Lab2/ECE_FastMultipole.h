@@ -0,0 +1,135 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the Cartesian fast multipole method evaluating electric fields
+ * */
+
+#ifndef LAB2_ECE_FASTMULTIPOLE_H
+#define LAB2_ECE_FASTMULTIPOLE_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+const int FMM_MAX_DEPTH = 10;           // deepest octree level, 1024 boxes per axis
+const std::size_t FMM_LEAF_SIZE = 64;   // target average number of charges per occupied leaf
+const int FMM_DEFAULT_ORDER = 6;        // default expansion order
+
+/**
+ * @brief A Cartesian Taylor-expansion fast multipole method.
+ *
+ * Sources and targets are sorted into a uniform-depth octree stored sparsely
+ * by Morton key. Multipole moments are formed at the leaves (P2M) and shifted
+ * up (M2M), converted to local expansions of well separated boxes (M2L) and
+ * shifted down (L2L). At the leaves the local expansion is differentiated for
+ * the far field (L2P) and the 27 neighbouring leaves are summed directly (P2P).
+ * Every pass is an OpenMP taskloop over the boxes of one level.
+ *
+ * The octree of the charges and its multipole moments are built once by the constructor,
+ * each batch only sorts its targets into the same boxes and runs the downward pass. Targets
+ * outside the root cube walk the charge boxes instead, evaluating the moments of every well
+ * separated box at the target (M2P) and summing the leaves next to them directly.
+ */
+class ECE_FastMultipole
+{
+protected:
+    /**
+     * @brief The occupied boxes of one octree level.
+     */
+    struct Level
+    {
+        std::vector<std::uint64_t> keys;  // sorted Morton keys of the boxes
+        std::vector<double> coefficients; // coefficientCount expansion coefficients per box
+    };
+
+    /**
+     * @brief The octree of the charges with their multipole expansions.
+     */
+    struct Tree
+    {
+        int depth;                                // level of the leaves
+        double originX, originY, originZ;         // lower corner of the root cube
+        double rootSize;                          // edge length of the root cube
+        std::vector<double> sx, sy, sz, sq;       // charges sorted by leaf
+        std::vector<Level> sources;               // multipole expansions per level
+        std::vector<std::size_t> sourceStart;     // charge range of each source leaf
+    };
+
+    /**
+     * @brief The boxes of one batch of targets, on the levels of the charge octree.
+     */
+    struct TargetTree
+    {
+        std::vector<std::size_t> targetOrder;     // indices of the targets inside the root cube, sorted by leaf
+        std::vector<std::size_t> outside;         // indices of the targets outside the root cube
+        std::vector<Level> targets;               // local expansions per level
+        std::vector<std::size_t> targetStart;     // targetOrder range of each target leaf
+    };
+
+    /**
+     * @brief Work space of one thread, so the passes allocate nothing per box.
+     */
+    struct Scratch
+    {
+        std::vector<double> px, py, pz;                 // powers of a displacement up to the order
+        std::vector<double> R;                          // recurrence table of derivatives
+        std::vector<std::size_t> neighbours;            // occupied source leaves around a target leaf
+        std::vector<std::pair<int, std::size_t>> boxes; // level and position of the source boxes left to visit
+    };
+
+    const ECE_ChargeArray &charges; // the charges producing the field
+    int order;                      // expansion order p
+    int numThreads;                 // number of OpenMP threads to use
+    int coefficientCount;           // number of multi-indices with |alpha| <= p
+    std::vector<int> powX, powY, powZ;       // exponents of each multi-index, ordered by degree
+    std::vector<int> indexTable;             // (a, b, c) -> multi-index number
+    std::vector<int> degreeCount;            // number of multi-indices with degree <= d
+    std::vector<double> inverseFactorial;    // 1 / (a! b! c!) of each multi-index
+    std::vector<double> sign;                // (-1)^|alpha| of each multi-index
+    Tree tree;                               // octree of the charges, empty if there are none
+
+    int index(int a, int b, int c) const;
+    std::uint64_t cellKey(double x, double y, double z) const;
+    void buildTree();
+    void buildTargets(TargetTree &targetTree, const std::vector<FieldPoint> &targets) const;
+    void boxCenter(int level, std::uint64_t key, double &cx, double &cy, double &cz) const;
+    void derivatives(double X, double Y, double Z, double *R) const;
+    std::vector<Scratch> makeScratch() const;
+    void upwardPass(std::vector<Scratch> &scratch);
+    void downwardPass(TargetTree &targetTree, std::vector<Scratch> &scratch) const;
+    void evaluateLeaves(const TargetTree &targetTree, const std::vector<FieldPoint> &targets,
+                        std::vector<FieldVector> &fields, std::vector<Scratch> &scratch) const;
+    void evaluateOutside(const TargetTree &targetTree, const std::vector<FieldPoint> &targets,
+                         std::vector<FieldVector> &fields, std::vector<Scratch> &scratch) const;
+public:
+    /**
+     * @brief Constructor for ECE_FastMultipole, builds the octree of the charges and its multipole moments.
+     *
+     * @param charges the charges producing the field, must outlive the object and not change
+     * @param order expansion order, higher is more accurate and slower
+     * @param numThreads number of OpenMP threads to use
+     */
+    ECE_FastMultipole(const ECE_ChargeArray &charges, int order, int numThreads);
+
+    /**
+     * @brief Computes the electric field at a batch of points.
+     *
+     * @param targets the points to evaluate
+     * @param fields the electric field at each point, resized to match targets
+     */
+    void computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const;
+
+    /**
+     * @brief Getter for the expansion order.
+     *
+     * @return the expansion order p
+     */
+    int getOrder() const;
+};
+
+
+#endif //LAB2_ECE_FASTMULTIPOLE_H
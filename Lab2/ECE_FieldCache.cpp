@@ -0,0 +1,79 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the cache of field totals at fixed probes, updated incrementally as charges change
+ * */
+
+#include "ECE_FieldCache.h"
+#include "ECE_FieldKernel.h"
+#include <cmath>
+
+ECE_FieldCache::ECE_FieldCache(ECE_ChargeArray &charges, const std::vector<FieldPoint> &probes, int numThreads)
+        : charges(charges), probes(probes), numThreads(numThreads)
+{
+    refresh();
+}
+
+void ECE_FieldCache::refresh()
+{
+    ECE_FieldSolver solver(charges, numThreads);
+    solver.computeFields(probes, fields);
+}
+
+void ECE_FieldCache::update(const std::vector<ChargeUpdate> &updates)
+{
+    // old states with negated charge followed by the new states, summed in one sweep per probe
+    ECE_ChargeArray delta;
+    delta.reserve(2 * updates.size());
+    for (const ChargeUpdate &change: updates)
+    {
+        std::size_t i = change.index;
+        delta.addCharge(charges.xData()[i], charges.yData()[i], charges.zData()[i], -charges.qData()[i]);
+    }
+    for (const ChargeUpdate &change: updates)
+    {
+        delta.addCharge(change.x, change.y, change.z, change.q);
+        charges.setCharge(change.index, change.x, change.y, change.z, change.q);
+    }
+
+#pragma omp parallel for schedule(static) num_threads(numThreads)
+    for (std::size_t p = 0; p < probes.size(); p++)
+    {
+        sumFieldAt(delta, 0, delta.size(), probes[p].x, probes[p].y, probes[p].z,
+                   fields[p].Ex, fields[p].Ey, fields[p].Ez);
+    }
+
+    // A charge sitting on a probe makes its contribution infinite, and subtracting it once the charge
+    // has moved away leaves NaN. Such probes are summed again, which gives what refresh() would.
+    std::vector<FieldPoint> stale;
+    std::vector<std::size_t> staleIndex;
+    for (std::size_t p = 0; p < probes.size(); p++)
+    {
+        if (!std::isfinite(fields[p].Ex) || !std::isfinite(fields[p].Ey) || !std::isfinite(fields[p].Ez))
+        {
+            stale.push_back(probes[p]);
+            staleIndex.push_back(p);
+        }
+    }
+    if (!stale.empty())
+    {
+        std::vector<FieldVector> fresh;
+        ECE_FieldSolver solver(charges, numThreads);
+        solver.computeFields(stale, fresh);
+        for (std::size_t s = 0; s < stale.size(); s++)
+        {
+            fields[staleIndex[s]] = fresh[s];
+        }
+    }
+}
+
+const std::vector<FieldVector> &ECE_FieldCache::getFields() const
+{
+    return fields;
+}
+
+const std::vector<FieldPoint> &ECE_FieldCache::getProbes() const
+{
+    return probes;
+}
@@ -0,0 +1,83 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the cache of field totals at fixed probes, updated incrementally as charges change
+ * */
+
+#ifndef LAB2_ECE_FIELDCACHE_H
+#define LAB2_ECE_FIELDCACHE_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A new position and value for one charge.
+ */
+struct ChargeUpdate
+{
+    std::size_t index; // index of the charge in the charge array
+    double x;          // new x coordinate
+    double y;          // new y coordinate
+    double z;          // new z coordinate
+    double q;          // new charge value
+};
+
+/**
+ * @brief The electric field at a fixed set of probes, kept up to date as charges move.
+ *
+ * The totals are computed once with the direct sum. An update subtracts the old contribution
+ * of every changed charge and adds the new one, costing O(changed x probes) instead of
+ * O(charges x probes). The old and new states are packed into one small charge array, the old
+ * ones with negated charge, and swept with the SIMD kernel. Each update rounds the totals
+ * once more, refresh() recomputes them from scratch when that drift matters. A probe whose total
+ * stops being finite, because a charge sat on it before or after the update, is summed again.
+ */
+class ECE_FieldCache
+{
+protected:
+    ECE_ChargeArray &charges;        // the charges, updated together with the totals
+    std::vector<FieldPoint> probes;  // the registered probe points
+    std::vector<FieldVector> fields; // the cached field at each probe
+    int numThreads;                  // number of OpenMP threads to use
+public:
+    /**
+     * @brief Constructor for ECE_FieldCache, computes the initial totals.
+     *
+     * @param charges the charges producing the field, must outlive the cache and only change through it
+     * @param probes the points at which the field is kept
+     * @param numThreads number of OpenMP threads to use
+     */
+    ECE_FieldCache(ECE_ChargeArray &charges, const std::vector<FieldPoint> &probes, int numThreads);
+
+    /**
+     * @brief Applies the updates to the charges and corrects the cached totals.
+     *
+     * @param updates the changed charges, each index at most once
+     */
+    void update(const std::vector<ChargeUpdate> &updates);
+
+    /**
+     * @brief Recomputes the totals from scratch with the direct sum.
+     */
+    void refresh();
+
+    /**
+     * @brief Getter for the cached field at each probe.
+     *
+     * @return one entry per probe, in registration order
+     */
+    const std::vector<FieldVector> &getFields() const;
+
+    /**
+     * @brief Getter for the probe points.
+     *
+     * @return the probes in registration order
+     */
+    const std::vector<FieldPoint> &getProbes() const;
+};
+
+
+#endif //LAB2_ECE_FIELDCACHE_H
@@ -0,0 +1,409 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the SIMD kernels summing electric fields over a charge array
+ * */
+
+#include "ECE_FieldKernel.h"
+#include "ECE_ElectricField.h"
+#include "ECE_FieldSolver.h"
+#include <cmath>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+const int FLUSH_INTERVAL = 8; // float vectors accumulated before the partial sums move to double
+
+/*
+ * SIMD traits: one struct per instruction set and precision with the handful of operations the
+ * kernel template needs. Offsets are always formed in double and then rounded to Real.
+ */
+#if defined(__AVX512F__)
+struct Avx512Double
+{
+    using Vec = __m512d;
+    using Acc = __m512d;
+    static constexpr std::size_t lanes = 8;
+    static constexpr bool single = false;
+    static __m512d target(double v) { return _mm512_set1_pd(v); }
+    static Vec splat(double v) { return _mm512_set1_pd(v); }
+    static Vec zero() { return _mm512_setzero_pd(); }
+    static Acc zeroAcc() { return _mm512_setzero_pd(); }
+    static Vec load(const double *p) { return _mm512_loadu_pd(p); }
+    static Vec offset(__m512d t, const double *p) { return _mm512_sub_pd(t, _mm512_loadu_pd(p)); }
+    static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a, b, c); }
+    static Vec inverseCube(Vec r2) { return _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_mul_pd(r2, _mm512_sqrt_pd(r2))); }
+    static Vec inverseRoot(Vec r2) { return _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(r2)); }
+    static bool anyBelow(Vec, Vec) { return false; }
+    static void flush(Vec part, Acc &acc) { acc = _mm512_add_pd(acc, part); }
+    static double reduce(Acc acc) { return _mm512_reduce_add_pd(acc); }
+};
+
+struct Avx512Float
+{
+    using Vec = __m512;
+    using Acc = __m512d;
+    static constexpr std::size_t lanes = 16;
+    static constexpr bool single = true;
+    static __m512d target(double v) { return _mm512_set1_pd(v); }
+    static Vec splat(double v) { return _mm512_set1_ps(static_cast<float>(v)); }
+    static Vec zero() { return _mm512_setzero_ps(); }
+    static Acc zeroAcc() { return _mm512_setzero_pd(); }
+    static Vec pack(__m512d low, __m512d high)
+    {
+        return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(low))),
+                                                   _mm256_castps_pd(_mm512_cvtpd_ps(high)), 1));
+    }
+    static Vec load(const double *p) { return pack(_mm512_loadu_pd(p), _mm512_loadu_pd(p + 8)); }
+    static Vec offset(__m512d t, const double *p)
+    {
+        return pack(_mm512_sub_pd(t, _mm512_loadu_pd(p)), _mm512_sub_pd(t, _mm512_loadu_pd(p + 8)));
+    }
+    static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static Vec inverseCube(Vec r2)
+    {
+        // 14-bit estimate, one Newton step brings it to about float precision
+        Vec inv = _mm512_rsqrt14_ps(r2);
+        inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), r2), _mm512_mul_ps(inv, inv),
+                                                  _mm512_set1_ps(1.5f)));
+        return _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv));
+    }
+    static bool anyBelow(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ) != 0; }
+    static void flush(Vec part, Acc &acc)
+    {
+        acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm512_castps512_ps256(part)));
+        acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(part), 1))));
+    }
+    static double reduce(Acc acc) { return _mm512_reduce_add_pd(acc); }
+};
+
+using DoubleTraits = Avx512Double;
+using FloatTraits = Avx512Float;
+#elif defined(__AVX2__)
+double reduce256(__m256d acc)
+{
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+struct Avx2Double
+{
+    using Vec = __m256d;
+    using Acc = __m256d;
+    static constexpr std::size_t lanes = 4;
+    static constexpr bool single = false;
+    static __m256d target(double v) { return _mm256_set1_pd(v); }
+    static Vec splat(double v) { return _mm256_set1_pd(v); }
+    static Vec zero() { return _mm256_setzero_pd(); }
+    static Acc zeroAcc() { return _mm256_setzero_pd(); }
+    static Vec load(const double *p) { return _mm256_loadu_pd(p); }
+    static Vec offset(__m256d t, const double *p) { return _mm256_sub_pd(t, _mm256_loadu_pd(p)); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+    static Vec inverseCube(Vec r2) { return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(r2, _mm256_sqrt_pd(r2))); }
+    static Vec inverseRoot(Vec r2) { return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(r2)); }
+    static bool anyBelow(Vec, Vec) { return false; }
+    static void flush(Vec part, Acc &acc) { acc = _mm256_add_pd(acc, part); }
+    static double reduce(Acc acc) { return reduce256(acc); }
+};
+
+struct Avx2Float
+{
+    using Vec = __m256;
+    using Acc = __m256d;
+    static constexpr std::size_t lanes = 8;
+    static constexpr bool single = true;
+    static __m256d target(double v) { return _mm256_set1_pd(v); }
+    static Vec splat(double v) { return _mm256_set1_ps(static_cast<float>(v)); }
+    static Vec zero() { return _mm256_setzero_ps(); }
+    static Acc zeroAcc() { return _mm256_setzero_pd(); }
+    static Vec pack(__m256d low, __m256d high) { return _mm256_set_m128(_mm256_cvtpd_ps(high), _mm256_cvtpd_ps(low)); }
+    static Vec load(const double *p) { return pack(_mm256_loadu_pd(p), _mm256_loadu_pd(p + 4)); }
+    static Vec offset(__m256d t, const double *p)
+    {
+        return pack(_mm256_sub_pd(t, _mm256_loadu_pd(p)), _mm256_sub_pd(t, _mm256_loadu_pd(p + 4)));
+    }
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    static Vec inverseCube(Vec r2)
+    {
+        // 12-bit estimate, one Newton step brings it to about float precision
+        Vec inv = _mm256_rsqrt_ps(r2);
+        inv = _mm256_mul_ps(inv, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r2),
+                                                                                   _mm256_mul_ps(inv, inv))));
+        return _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv));
+    }
+    static bool anyBelow(Vec a, Vec b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)) != 0; }
+    static void flush(Vec part, Acc &acc)
+    {
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(part)));
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(part, 1)));
+    }
+    static double reduce(Acc acc) { return reduce256(acc); }
+};
+
+using DoubleTraits = Avx2Double;
+using FloatTraits = Avx2Float;
+#endif
+
+template<typename Real, bool Planar, bool Uniform>
+void sumFieldAtSpecialized(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                           double x, double y, double z, double nearDistanceSquared,
+                           double &Ex, double &Ey, double &Ez);
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+/**
+ * @brief The SIMD part of the kernel, advances i past the last full vector.
+ *
+ * Planar sources have z = 0, so dz is the target's z for every charge and only the sum of
+ * the weights is needed for Ez. Uniform sources multiply by q once at the end. Both decisions
+ * are made at compile time, the loop body itself has no branches apart from the near check
+ * that float vectors need.
+ */
+template<typename Traits, bool Planar, bool Uniform>
+void sumVectors(const ECE_ChargeArray &charges, std::size_t &i, std::size_t end, double x, double y, double z,
+                double nearDistanceSquared, double &sumX, double &sumY, double &sumZ,
+                double &Ex, double &Ey, double &Ez)
+{
+    using Vec = typename Traits::Vec;
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+
+    auto tx = Traits::target(x), ty = Traits::target(y), tz = Traits::target(z);
+    Vec dzPlanar = Traits::splat(z), zSquared = Traits::splat(z * z);
+    Vec nearSquared = Traits::splat(nearDistanceSquared);
+    auto accX = Traits::zeroAcc(), accY = Traits::zeroAcc(), accZ = Traits::zeroAcc();
+    Vec partX = Traits::zero(), partY = Traits::zero(), partZ = Traits::zero();
+    int pending = 0;
+    for (; i + Traits::lanes <= end; i += Traits::lanes)
+    {
+        Vec dx = Traits::offset(tx, xs + i);
+        Vec dy = Traits::offset(ty, ys + i);
+        Vec dz = Planar ? dzPlanar : Traits::offset(tz, zs + i);
+        Vec r2 = Planar ? Traits::fmadd(dy, dy, Traits::fmadd(dx, dx, zSquared))
+                        : Traits::fmadd(dz, dz, Traits::fmadd(dy, dy, Traits::mul(dx, dx)));
+        if (Traits::single && Traits::anyBelow(r2, nearSquared))
+        {
+            sumFieldAtSpecialized<double, Planar, Uniform>(charges, i, i + Traits::lanes, x, y, z, 0, Ex, Ey, Ez);
+            continue;
+        }
+        Vec s = Traits::inverseCube(r2);
+        if constexpr (!Uniform)
+        {
+            s = Traits::mul(Traits::load(qs + i), s);
+        }
+        partX = Traits::fmadd(dx, s, partX);
+        partY = Traits::fmadd(dy, s, partY);
+        partZ = Planar ? Traits::add(partZ, s) : Traits::fmadd(dz, s, partZ);
+        if (Traits::single && ++pending == FLUSH_INTERVAL)
+        {
+            Traits::flush(partX, accX);
+            Traits::flush(partY, accY);
+            Traits::flush(partZ, accZ);
+            partX = partY = partZ = Traits::zero();
+            pending = 0;
+        }
+    }
+    Traits::flush(partX, accX);
+    Traits::flush(partY, accY);
+    Traits::flush(partZ, accZ);
+    sumX = Traits::reduce(accX);
+    sumY = Traits::reduce(accY);
+    sumZ = Traits::reduce(accZ);
+}
+#endif
+
+/**
+ * @brief The kernel specialized for the precision and the shape of the sources.
+ *
+ * Without AVX2 or AVX-512 the float variants have no lanes to gain and sum in double.
+ */
+template<typename Real, bool Planar, bool Uniform>
+void sumFieldAtSpecialized(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                           double x, double y, double z, double nearDistanceSquared,
+                           double &Ex, double &Ey, double &Ez)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+
+    double sumX = 0, sumY = 0, sumZ = 0;
+    std::size_t i = begin;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    using Traits = typename std::conditional<std::is_same<Real, float>::value, FloatTraits, DoubleTraits>::type;
+    sumVectors<Traits, Planar, Uniform>(charges, i, end, x, y, z, nearDistanceSquared, sumX, sumY, sumZ, Ex, Ey, Ez);
+#else
+    (void) nearDistanceSquared;
+#endif
+
+    // scalar fallback in double, also picks up the tail of the SIMD loop
+    for (; i < end; i++)
+    {
+        double dx = x - xs[i];
+        double dy = y - ys[i];
+        double dz = Planar ? z : z - zs[i];
+        double r2 = dx * dx + dy * dy + dz * dz;
+        double s = 1.0 / (r2 * std::sqrt(r2));
+        if constexpr (!Uniform)
+        {
+            s *= qs[i];
+        }
+        sumX += dx * s;
+        sumY += dy * s;
+        sumZ += Planar ? s : dz * s;
+    }
+
+    double scale = Uniform ? K * qs[begin] : K;
+    Ex += scale * sumX;
+    Ey += scale * sumY;
+    Ez += scale * (Planar ? z * sumZ : sumZ);
+}
+}
+
+void sumFieldDerivativesAt(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                           double x, double y, double z, FieldDerivatives &result)
+{
+    const double *xs = charges.xData();
+    const double *ys = charges.yData();
+    const double *zs = charges.zData();
+    const double *qs = charges.qData();
+
+    // potential, field and the six distinct entries of the symmetric gradient
+    double sumV = 0, sumX = 0, sumY = 0, sumZ = 0;
+    double sumXX = 0, sumYY = 0, sumZZ = 0, sumXY = 0, sumXZ = 0, sumYZ = 0;
+    std::size_t i = begin;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    using Traits = DoubleTraits;
+    using Vec = Traits::Vec;
+    Vec tx = Traits::splat(x), ty = Traits::splat(y), tz = Traits::splat(z), three = Traits::splat(3.0);
+    Vec accV = Traits::zero(), accX = Traits::zero(), accY = Traits::zero(), accZ = Traits::zero();
+    Vec accXX = Traits::zero(), accYY = Traits::zero(), accZZ = Traits::zero();
+    Vec accXY = Traits::zero(), accXZ = Traits::zero(), accYZ = Traits::zero();
+    for (; i + Traits::lanes <= end; i += Traits::lanes)
+    {
+        Vec dx = Traits::offset(tx, xs + i);
+        Vec dy = Traits::offset(ty, ys + i);
+        Vec dz = Traits::offset(tz, zs + i);
+        Vec r2 = Traits::fmadd(dz, dz, Traits::fmadd(dy, dy, Traits::mul(dx, dx)));
+        Vec inv = Traits::inverseRoot(r2);
+        Vec inv2 = Traits::mul(inv, inv);
+        Vec qInv = Traits::mul(Traits::load(qs + i), inv);  // q / r
+        Vec w3 = Traits::mul(qInv, inv2);                    // q / r^3
+        Vec w5 = Traits::mul(three, Traits::mul(w3, inv2));  // 3 q / r^5
+        accV = Traits::add(accV, qInv);
+        accX = Traits::fmadd(dx, w3, accX);
+        accY = Traits::fmadd(dy, w3, accY);
+        accZ = Traits::fmadd(dz, w3, accZ);
+        Vec w5x = Traits::mul(dx, w5), w5y = Traits::mul(dy, w5);
+        accXX = Traits::add(accXX, Traits::sub(w3, Traits::mul(dx, w5x)));
+        accYY = Traits::add(accYY, Traits::sub(w3, Traits::mul(dy, w5y)));
+        accZZ = Traits::add(accZZ, Traits::sub(w3, Traits::mul(dz, Traits::mul(dz, w5))));
+        accXY = Traits::fmadd(dy, w5x, accXY);
+        accXZ = Traits::fmadd(dz, w5x, accXZ);
+        accYZ = Traits::fmadd(dz, w5y, accYZ);
+    }
+    sumV = Traits::reduce(accV);
+    sumX = Traits::reduce(accX);
+    sumY = Traits::reduce(accY);
+    sumZ = Traits::reduce(accZ);
+    sumXX = Traits::reduce(accXX);
+    sumYY = Traits::reduce(accYY);
+    sumZZ = Traits::reduce(accZZ);
+    sumXY = Traits::reduce(accXY);
+    sumXZ = Traits::reduce(accXZ);
+    sumYZ = Traits::reduce(accYZ);
+#endif
+
+    // scalar fallback, also picks up the tail of the SIMD loop
+    for (; i < end; i++)
+    {
+        double dx = x - xs[i];
+        double dy = y - ys[i];
+        double dz = z - zs[i];
+        double r2 = dx * dx + dy * dy + dz * dz;
+        double inv = 1.0 / std::sqrt(r2);
+        double qInv = qs[i] * inv;
+        double w3 = qInv * inv * inv;
+        double w5 = 3.0 * w3 * inv * inv;
+        sumV += qInv;
+        sumX += dx * w3;
+        sumY += dy * w3;
+        sumZ += dz * w3;
+        sumXX += w3 - dx * dx * w5;
+        sumYY += w3 - dy * dy * w5;
+        sumZZ += w3 - dz * dz * w5;
+        sumXY += dx * dy * w5;
+        sumXZ += dx * dz * w5;
+        sumYZ += dy * dz * w5;
+    }
+
+    // the off-diagonal sums hold +3 q d_i d_j / r^5, the gradient entry has the opposite sign
+    result.potential += K * sumV;
+    result.Ex += K * sumX;
+    result.Ey += K * sumY;
+    result.Ez += K * sumZ;
+    result.gradient[0][0] += K * sumXX;
+    result.gradient[1][1] += K * sumYY;
+    result.gradient[2][2] += K * sumZZ;
+    result.gradient[0][1] -= K * sumXY;
+    result.gradient[0][2] -= K * sumXZ;
+    result.gradient[1][2] -= K * sumYZ;
+    result.gradient[1][0] = result.gradient[0][1];
+    result.gradient[2][0] = result.gradient[0][2];
+    result.gradient[2][1] = result.gradient[1][2];
+}
+
+void sumFieldAt(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                double x, double y, double z, double &Ex, double &Ey, double &Ez)
+{
+    sumFieldAtSpecialized<double, false, false>(charges, begin, end, x, y, z, 0, Ex, Ey, Ez);
+}
+
+void sumFieldAtMixed(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                     double x, double y, double z, double nearDistanceSquared,
+                     double &Ex, double &Ey, double &Ez)
+{
+    sumFieldAtSpecialized<float, false, false>(charges, begin, end, x, y, z, nearDistanceSquared, Ex, Ey, Ez);
+}
+
+FieldKernel selectFieldKernel(bool mixedPrecision, bool planar, bool uniform)
+{
+    static const FieldKernel kernels[2][2][2] = {
+            {{sumFieldAtSpecialized<double, false, false>, sumFieldAtSpecialized<double, false, true>},
+             {sumFieldAtSpecialized<double, true, false>, sumFieldAtSpecialized<double, true, true>}},
+            {{sumFieldAtSpecialized<float, false, false>, sumFieldAtSpecialized<float, false, true>},
+             {sumFieldAtSpecialized<float, true, false>, sumFieldAtSpecialized<float, true, true>}}};
+    return kernels[mixedPrecision][planar][uniform];
+}
+
+const char *fieldKernelName()
+{
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,110 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the SIMD kernels summing electric fields over a charge array
+ * */
+
+#ifndef LAB2_ECE_FIELDKERNEL_H
+#define LAB2_ECE_FIELDKERNEL_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+
+/**
+ * @brief Sums the electric field of a range of charges at a target point.
+ *
+ * Evaluates charges [begin, end) of the array with the widest SIMD instruction set
+ * the file was compiled for (AVX-512, AVX2 or a scalar fallback) and adds the
+ * result to Ex, Ey, Ez.
+ *
+ * @param charges the charge collection
+ * @param begin index of the first charge in the range
+ * @param end index one past the last charge in the range
+ * @param x x coordinate of the target point
+ * @param y y coordinate of the target point
+ * @param z z coordinate of the target point
+ * @param Ex accumulated electric field in the x direction
+ * @param Ey accumulated electric field in the y direction
+ * @param Ez accumulated electric field in the z direction
+ */
+void sumFieldAt(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                double x, double y, double z, double &Ex, double &Ey, double &Ez);
+
+struct FieldDerivatives;
+
+/**
+ * @brief Sums potential, field and field gradient of a range of charges in one pass.
+ *
+ * Reuses 1/r for the potential, q/r^3 for the field and 3q/r^5 for the gradient
+ * dE_i/dx_j = K q (delta_ij / r^3 - 3 d_i d_j / r^5), with d the offset from the charge.
+ * Only the six distinct entries of the symmetric gradient are summed. Everything is added
+ * to result, the lower triangle of the gradient is then mirrored from the upper one.
+ *
+ * @param charges the charge collection
+ * @param begin index of the first charge in the range
+ * @param end index one past the last charge in the range
+ * @param x x coordinate of the target point
+ * @param y y coordinate of the target point
+ * @param z z coordinate of the target point
+ * @param result accumulated potential, field and gradient
+ */
+void sumFieldDerivativesAt(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                           double x, double y, double z, FieldDerivatives &result);
+
+/**
+ * @brief Mixed-precision variant of sumFieldAt.
+ *
+ * Offsets to the target are formed in double and rounded to float, 1/r^3 comes from a
+ * reciprocal square root estimate refined by one Newton step, and the float partial sums
+ * are flushed into double accumulators every few vectors. A SIMD vector holds twice as
+ * many float lanes as double lanes. Any vector with a charge closer than the near distance
+ * is recomputed with the double kernel, where float would lose the nearly singular term.
+ * Without AVX2 or AVX-512 this is the double kernel.
+ *
+ * @param charges the charge collection
+ * @param begin index of the first charge in the range
+ * @param end index one past the last charge in the range
+ * @param x x coordinate of the target point
+ * @param y y coordinate of the target point
+ * @param z z coordinate of the target point
+ * @param nearDistanceSquared squared distance below which the double kernel is used
+ * @param Ex accumulated electric field in the x direction
+ * @param Ey accumulated electric field in the y direction
+ * @param Ez accumulated electric field in the z direction
+ */
+void sumFieldAtMixed(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                     double x, double y, double z, double nearDistanceSquared,
+                     double &Ex, double &Ey, double &Ez);
+
+/**
+ * @brief A field kernel with the signature of sumFieldAtMixed, the double kernels ignore nearDistanceSquared.
+ */
+using FieldKernel = void (*)(const ECE_ChargeArray &charges, std::size_t begin, std::size_t end,
+                             double x, double y, double z, double nearDistanceSquared,
+                             double &Ex, double &Ey, double &Ez);
+
+/**
+ * @brief Picks the kernel compiled for a precision and a shape of the charge distribution.
+ *
+ * Every combination is a separate instantiation of one kernel template, so the inner loop
+ * carries no per-charge decisions. Planar kernels assume z = 0 for every charge and never load
+ * z, uniform kernels assume every charge equals the first one of the range and never load q.
+ * Callers select once per batch, e.g. from ECE_ChargeArray::isPlanar and hasUniformCharge.
+ *
+ * @param mixedPrecision true for the float kernels of sumFieldAtMixed, false for double
+ * @param planar true if every charge lies on the z = 0 plane
+ * @param uniform true if every charge carries the same value
+ * @return the kernel
+ */
+FieldKernel selectFieldKernel(bool mixedPrecision, bool planar, bool uniform);
+
+/**
+ * @brief Getter for the instruction set used by sumFieldAt.
+ *
+ * @return "AVX-512", "AVX2" or "scalar"
+ */
+const char *fieldKernelName();
+
+
+#endif //LAB2_ECE_FIELDKERNEL_H
@@ -0,0 +1,124 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the regular-grid field map streamed to a binary file slab by slab
+ * */
+
+#include "ECE_FieldMap.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+
+ECE_FieldMap::ECE_FieldMap(FieldPoint lower, FieldPoint upper, int nx, int ny, int nz)
+        : lower(lower), upper(upper), nx(nx), ny(ny), nz(nz) {}
+
+std::size_t ECE_FieldMap::voxelCount() const
+{
+    return static_cast<std::size_t>(nx) * ny * nz;
+}
+
+double ECE_FieldMap::coordinate(double low, double high, int index, int count)
+{
+    return count > 1 ? low + (high - low) * index / (count - 1) : low;
+}
+
+std::string ECE_FieldMap::npyHeader() const
+{
+    std::string dictionary = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + std::to_string(nz) + ", " +
+                             std::to_string(ny) + ", " + std::to_string(nx) + ", " +
+                             std::to_string(FIELD_MAP_COMPONENTS) + "), }";
+    // magic, version and length take 10 bytes, the dictionary is padded so the data starts 64-byte aligned
+    std::size_t total = (10 + dictionary.size() + 1 + 63) / 64 * 64;
+    dictionary.append(total - 10 - dictionary.size() - 1, ' ');
+    dictionary += '\n';
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header += static_cast<char>(dictionary.size() & 0xff);
+    header += static_cast<char>(dictionary.size() >> 8);
+    return header + dictionary;
+}
+
+bool ECE_FieldMap::write(const std::string &path, FieldMapFormat format, const Evaluator &evaluate,
+                         int numThreads) const
+{
+    std::unique_ptr<FILE, int (*)(FILE *)> file(std::fopen(path.c_str(), "wb"), &std::fclose);
+    if (!file)
+    {
+        return false;
+    }
+    if (format == FieldMapFormat::Npy)
+    {
+        std::string header = npyHeader();
+        if (std::fwrite(header.data(), 1, header.size(), file.get()) != header.size())
+        {
+            return false;
+        }
+    }
+    else
+    {
+        FieldMapHeader header = {};
+        std::memcpy(header.magic, "EFIELD01", sizeof(header.magic));
+        header.nx = nx;
+        header.ny = ny;
+        header.nz = nz;
+        header.components = FIELD_MAP_COMPONENTS;
+        header.lower[0] = lower.x;
+        header.lower[1] = lower.y;
+        header.lower[2] = lower.z;
+        header.upper[0] = upper.x;
+        header.upper[1] = upper.y;
+        header.upper[2] = upper.z;
+        if (std::fwrite(&header, sizeof(header), 1, file.get()) != 1)
+        {
+            return false;
+        }
+    }
+
+    std::size_t slabSize = static_cast<std::size_t>(nx) * ny;
+    std::vector<FieldPoint> targets(slabSize);
+    std::vector<FieldVector> fields;
+    std::vector<float> buffers[2];
+    std::future<bool> pending;
+    for (int k = 0; k < nz; k++)
+    {
+        double z = coordinate(lower.z, upper.z, k, nz);
+        for (int j = 0; j < ny; j++)
+        {
+            double y = coordinate(lower.y, upper.y, j, ny);
+            for (int i = 0; i < nx; i++)
+            {
+                targets[static_cast<std::size_t>(j) * nx + i] = {coordinate(lower.x, upper.x, i, nx), y, z};
+            }
+        }
+        evaluate(targets, fields);
+
+        // the previous slab was written while this one was evaluated, the file must stay in slab order
+        if (pending.valid() && !pending.get())
+        {
+            return false;
+        }
+        std::vector<float> &buffer = buffers[k % 2];
+        buffer.resize(slabSize * FIELD_MAP_COMPONENTS);
+#pragma omp parallel for num_threads(numThreads)
+        for (std::size_t v = 0; v < slabSize; v++)
+        {
+            const FieldVector &field = fields[v];
+            buffer[v * FIELD_MAP_COMPONENTS] = static_cast<float>(field.Ex);
+            buffer[v * FIELD_MAP_COMPONENTS + 1] = static_cast<float>(field.Ey);
+            buffer[v * FIELD_MAP_COMPONENTS + 2] = static_cast<float>(field.Ez);
+            buffer[v * FIELD_MAP_COMPONENTS + 3] = static_cast<float>(
+                    std::sqrt(field.Ex * field.Ex + field.Ey * field.Ey + field.Ez * field.Ez));
+        }
+        FILE *stream = file.get();
+        pending = std::async(std::launch::async, [stream, &buffer]() {
+            return std::fwrite(buffer.data(), sizeof(float), buffer.size(), stream) == buffer.size();
+        });
+    }
+    if (pending.valid() && !pending.get())
+    {
+        return false;
+    }
+    return std::fflush(file.get()) == 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the regular-grid field map streamed to a binary file slab by slab
+ * */
+
+#ifndef LAB2_ECE_FIELDMAP_H
+#define LAB2_ECE_FIELDMAP_H
+
+#include "ECE_FieldSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+const int FIELD_MAP_COMPONENTS = 4; // Ex, Ey, Ez and |E| per voxel
+
+/**
+ * @brief File layouts written by ECE_FieldMap.
+ */
+enum class FieldMapFormat
+{
+    Raw, // FieldMapHeader followed by the float data
+    Npy  // NumPy .npy version 1.0 file, loadable with numpy.load or numpy.memmap
+};
+
+/**
+ * @brief The header of a raw field map file, followed by nz * ny * nx * 4 little-endian floats.
+ */
+struct FieldMapHeader
+{
+    char magic[8];              // "EFIELD01"
+    std::uint32_t nx, ny, nz;   // number of voxels along each axis, x varies fastest
+    std::uint32_t components;   // FIELD_MAP_COMPONENTS
+    double lower[3];            // coordinates of voxel (0, 0, 0)
+    double upper[3];            // coordinates of voxel (nx - 1, ny - 1, nz - 1)
+};
+
+/**
+ * @brief A regular grid of voxels spanning a bounding box, evaluated one z slab at a time.
+ *
+ * Only two slabs are held in memory: while one is evaluated, the float copy of the previous
+ * one is written by a background thread. A 1024^3 map therefore needs about 100 MB of
+ * RAM no matter how large the 16 GB file grows. Voxels are the nodes of the grid, including the
+ * faces of the box. A voxel that coincides with a charge holds non-finite values.
+ */
+class ECE_FieldMap
+{
+protected:
+    FieldPoint lower; // coordinates of voxel (0, 0, 0)
+    FieldPoint upper; // coordinates of voxel (nx - 1, ny - 1, nz - 1)
+    int nx, ny, nz;   // number of voxels along each axis
+
+    static double coordinate(double low, double high, int index, int count);
+    std::string npyHeader() const;
+public:
+    /**
+     * @brief Evaluates the field at a batch of points, e.g. ECE_FieldSolver::computeFields.
+     */
+    using Evaluator = std::function<void(const std::vector<FieldPoint> &, std::vector<FieldVector> &)>;
+
+    /**
+     * @brief Constructor for ECE_FieldMap.
+     *
+     * @param lower the corner of the box with the smallest coordinates
+     * @param upper the opposite corner of the box
+     * @param nx number of voxels along x
+     * @param ny number of voxels along y
+     * @param nz number of voxels along z
+     */
+    ECE_FieldMap(FieldPoint lower, FieldPoint upper, int nx, int ny, int nz);
+
+    /**
+     * @brief Evaluates every voxel and streams the result to a file.
+     *
+     * @param path the file to create
+     * @param format the file layout
+     * @param evaluate the field evaluator, called once per z slab with nx * ny targets
+     * @param numThreads number of OpenMP threads converting each slab to float, the evaluator's team
+     * @return false if the file could not be created or written
+     */
+    bool write(const std::string &path, FieldMapFormat format, const Evaluator &evaluate, int numThreads) const;
+
+    /**
+     * @brief Getter for the number of voxels.
+     *
+     * @return nx * ny * nz
+     */
+    std::size_t voxelCount() const;
+};
+
+
+#endif //LAB2_ECE_FIELDMAP_H
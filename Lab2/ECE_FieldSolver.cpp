@@ -0,0 +1,436 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the class evaluating electric fields of a charge array at one or many targets
+ * */
+
+#include "ECE_FieldSolver.h"
+#include "ECE_BarnesHut.h"
+#include "ECE_CellList.h"
+#include "ECE_FastMultipole.h"
+#include "ECE_FieldKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+ECE_FieldSolver::ECE_FieldSolver(const ECE_ChargeArray &charges, int numThreads)
+        : charges(charges), numThreads(numThreads) {}
+
+ECE_FieldSolver::~ECE_FieldSolver() = default;
+
+void ECE_FieldSolver::useBarnesHut(double theta)
+{
+    fmm.reset();
+    cells.reset();
+    tree = std::make_unique<ECE_BarnesHut>(charges, theta, numThreads);
+}
+
+void ECE_FieldSolver::useFastMultipole(int order)
+{
+    tree.reset();
+    cells.reset();
+    fmm = std::make_unique<ECE_FastMultipole>(charges, order, numThreads);
+}
+
+void ECE_FieldSolver::useCutoff(double cutoff, InteractionType type, double screeningLength)
+{
+    tree.reset();
+    fmm.reset();
+    cells = std::make_unique<ECE_CellList>(charges, cutoff, type, screeningLength, numThreads);
+}
+
+void ECE_FieldSolver::setDeterministic(bool enabled)
+{
+    deterministic = enabled;
+}
+
+void ECE_FieldSolver::setMixedPrecision(bool enabled, double nearDistance)
+{
+    mixedPrecision = enabled;
+    if (nearDistance <= 0 && charges.size() > 0)
+    {
+        const double *xs = charges.xData(), *ys = charges.yData(), *zs = charges.zData();
+        auto xRange = std::minmax_element(xs, xs + charges.size());
+        auto yRange = std::minmax_element(ys, ys + charges.size());
+        auto zRange = std::minmax_element(zs, zs + charges.size());
+        double diagonal = std::sqrt(std::pow(*xRange.second - *xRange.first, 2) +
+                                    std::pow(*yRange.second - *yRange.first, 2) +
+                                    std::pow(*zRange.second - *zRange.first, 2));
+        nearDistance = diagonal > 0 ? 1e-3 * diagonal : 1e-6;
+    }
+    nearDistanceSquared = nearDistance * nearDistance;
+}
+
+/**
+ * @brief Adds every component of value to sum.
+ */
+static void addInPlace(FieldVector &sum, const FieldVector &value)
+{
+    sum.Ex += value.Ex;
+    sum.Ey += value.Ey;
+    sum.Ez += value.Ez;
+}
+
+/**
+ * @brief Adds every component of value to sum.
+ */
+static void addInPlace(FieldDerivatives &sum, const FieldDerivatives &value)
+{
+    sum.potential += value.potential;
+    sum.Ex += value.Ex;
+    sum.Ey += value.Ey;
+    sum.Ez += value.Ez;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            sum.gradient[i][j] += value.gradient[i][j];
+        }
+    }
+}
+
+/**
+ * @brief Number of partial sums pairwisePush keeps for count entries, one per bit of the count.
+ */
+static std::size_t pairwiseLevels(std::size_t count)
+{
+    std::size_t levels = 1;
+    while (levels < 64 && (std::size_t(1) << levels) <= count)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+/**
+ * @brief Adds entry index of a fixed pairwise tree, the entries must arrive in order.
+ *
+ * Like a binary counter, the entry is merged with the partial sum of every trailing one bit of
+ * its index, left operand first, and the result takes the level of the first zero bit. Only one
+ * partial sum per level is alive, so a tree over n entries needs pairwiseLevels(n) of them.
+ */
+template<typename Value>
+static void pairwisePush(Value *levels, std::size_t index, Value value)
+{
+    std::size_t level = 0;
+    for (; index & (std::size_t(1) << level); level++)
+    {
+        Value sum = levels[level];
+        addInPlace(sum, value);
+        value = sum;
+    }
+    levels[level] = value;
+}
+
+/**
+ * @brief Combines the partial sums left by count calls of pairwisePush, the lowest level last.
+ *
+ * The result is the same as adding neighbouring pairs level by level and carrying an odd last
+ * entry to the next level, it only depends on the order of the entries.
+ */
+template<typename Value>
+static Value pairwiseFinish(const Value *levels, std::size_t count)
+{
+    Value total = Value();
+    bool first = true;
+    for (std::size_t level = 0; count >> level; level++)
+    {
+        if ((count >> level) & 1)
+        {
+            Value sum = levels[level];
+            if (!first)
+            {
+                addInPlace(sum, total);
+            }
+            total = sum;
+            first = false;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Sums the entries with the fixed pairwise tree of pairwisePush.
+ */
+template<typename Value>
+static Value pairwiseSum(const Value *partial, std::size_t count)
+{
+    std::vector<Value> levels(pairwiseLevels(count));
+    for (std::size_t i = 0; i < count; i++)
+    {
+        pairwisePush(levels.data(), i, partial[i]);
+    }
+    return pairwiseFinish(levels.data(), count);
+}
+
+void ECE_FieldSolver::useDirectSum()
+{
+    tree.reset();
+    fmm.reset();
+    cells.reset();
+}
+
+FieldVector ECE_FieldSolver::computeField(double x, double y, double z, std::vector<WorkerStats> *stats) const
+{
+    if (stats && (tree || cells || fmm))
+    {
+        stats->clear();
+    }
+    if (tree)
+    {
+        return tree->computeField(x, y, z);
+    }
+    if (cells)
+    {
+        return cells->computeField(x, y, z);
+    }
+    if (fmm)
+    {
+        std::vector<FieldVector> fields;
+        fmm->computeFields({{x, y, z}}, fields);
+        return fields[0];
+    }
+    return computeDirectField(x, y, z, stats);
+}
+
+void ECE_FieldSolver::computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const
+{
+    if (fmm)
+    {
+        fmm->computeFields(targets, fields);
+        return;
+    }
+    if (!tree && !cells)
+    {
+        computeDirectFields(targets, fields);
+        return;
+    }
+    fields.resize(targets.size());
+#pragma omp parallel for schedule(dynamic, TARGET_BLOCK) num_threads(numThreads)
+    for (std::size_t t = 0; t < targets.size(); t++)
+    {
+        fields[t] = tree ? tree->computeField(targets[t].x, targets[t].y, targets[t].z)
+                         : cells->computeField(targets[t].x, targets[t].y, targets[t].z);
+    }
+}
+
+FieldError ECE_FieldSolver::measureError(const std::vector<FieldPoint> &samples) const
+{
+    std::vector<FieldVector> approx, exact;
+    computeFields(samples, approx);
+    computeDirectFields(samples, exact);
+
+    FieldError error = {0, 0};
+    for (std::size_t t = 0; t < samples.size(); t++)
+    {
+        double dx = approx[t].Ex - exact[t].Ex;
+        double dy = approx[t].Ey - exact[t].Ey;
+        double dz = approx[t].Ez - exact[t].Ez;
+        double norm = std::sqrt(exact[t].Ex * exact[t].Ex + exact[t].Ey * exact[t].Ey + exact[t].Ez * exact[t].Ez);
+        double relative = norm > 0 ? std::sqrt(dx * dx + dy * dy + dz * dz) / norm : 0;
+        error.maxRelative = std::max(error.maxRelative, relative);
+        error.rmsRelative += relative * relative;
+    }
+    if (!samples.empty())
+    {
+        error.rmsRelative = std::sqrt(error.rmsRelative / samples.size());
+    }
+    return error;
+}
+
+FieldVector ECE_FieldSolver::computeDirectField(double x, double y, double z, std::vector<WorkerStats> *stats) const
+{
+    FieldKernel kernel = selectFieldKernel(mixedPrecision, charges.isPlanar(), charges.hasUniformCharge());
+    if (deterministic)
+    {
+        // the blocks are fixed by the charge count alone, so it does not matter which thread sums which
+        std::size_t count = charges.size();
+        std::size_t blockCount = (count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+        std::vector<FieldVector> partial(blockCount, {0, 0, 0});
+        ECE_RangeScheduler scheduler(0, blockCount, numThreads,
+                                     ECE_RangeScheduler::adaptiveGrain(blockCount, numThreads, 8));
+#pragma omp parallel num_threads(numThreads)
+        scheduler.run(omp_get_thread_num(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t block = begin; block < end; block++)
+            {
+                kernel(charges, block * REDUCTION_BLOCK, std::min((block + 1) * REDUCTION_BLOCK, count),
+                       x, y, z, nearDistanceSquared, partial[block].Ex, partial[block].Ey, partial[block].Ez);
+            }
+        });
+        if (stats)
+        {
+            *stats = scheduler.getStats();
+        }
+        return pairwiseSum(partial.data(), partial.size());
+    }
+
+    double Ex = 0, Ey = 0, Ez = 0;
+    ECE_RangeScheduler scheduler(0, charges.size(), numThreads,
+                                 ECE_RangeScheduler::adaptiveGrain(charges.size(), numThreads, CHARGE_TILE));
+#pragma omp parallel reduction(+:Ex, Ey, Ez) num_threads(numThreads)
+    scheduler.run(omp_get_thread_num(), [&](std::size_t begin, std::size_t end) {
+        kernel(charges, begin, end, x, y, z, nearDistanceSquared, Ex, Ey, Ez);
+    });
+    if (stats)
+    {
+        *stats = scheduler.getStats();
+    }
+    return {Ex, Ey, Ez};
+}
+
+void ECE_FieldSolver::computeDirectFields(const std::vector<FieldPoint> &targets,
+                                          std::vector<FieldVector> &fields) const
+{
+    fields.assign(targets.size(), {0, 0, 0});
+    std::size_t blockCount = (targets.size() + TARGET_BLOCK - 1) / TARGET_BLOCK;
+
+    // too few targets to keep every thread busy, parallelize over the charges instead
+    if (blockCount < static_cast<std::size_t>(numThreads))
+    {
+        for (std::size_t t = 0; t < targets.size(); t++)
+        {
+            fields[t] = computeDirectField(targets[t].x, targets[t].y, targets[t].z, nullptr);
+        }
+        return;
+    }
+
+    std::size_t chargeCount = charges.size();
+    std::size_t reductionBlocks = (chargeCount + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    std::size_t levelCount = pairwiseLevels(reductionBlocks);
+    FieldKernel kernel = selectFieldKernel(mixedPrecision, charges.isPlanar(), charges.hasUniformCharge());
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+    for (std::size_t block = 0; block < blockCount; block++)
+    {
+        std::size_t first = block * TARGET_BLOCK;
+        std::size_t last = std::min(first + TARGET_BLOCK, targets.size());
+        // Each target is summed tile by tile by a single thread, so the order is already independent
+        // of the thread count. The deterministic mode feeds the sum of every REDUCTION_BLOCK of charges
+        // into the pairwise tree of computeDirectField as it is done, keeping one partial per level.
+        std::vector<FieldVector> levels(deterministic ? (last - first) * levelCount : 0);
+        for (std::size_t tile = 0; tile < chargeCount; tile += CHARGE_TILE)
+        {
+            std::size_t tileEnd = std::min(tile + CHARGE_TILE, chargeCount);
+            for (std::size_t t = first; t < last; t++)
+            {
+                if (!deterministic)
+                {
+                    kernel(charges, tile, tileEnd, targets[t].x, targets[t].y, targets[t].z, nearDistanceSquared,
+                           fields[t].Ex, fields[t].Ey, fields[t].Ez);
+                    continue;
+                }
+                for (std::size_t begin = tile; begin < tileEnd; begin += REDUCTION_BLOCK)
+                {
+                    FieldVector sum = {0, 0, 0};
+                    kernel(charges, begin, std::min(begin + REDUCTION_BLOCK, chargeCount), targets[t].x,
+                           targets[t].y, targets[t].z, nearDistanceSquared, sum.Ex, sum.Ey, sum.Ez);
+                    pairwisePush(&levels[(t - first) * levelCount], begin / REDUCTION_BLOCK, sum);
+                }
+            }
+        }
+        for (std::size_t t = first; deterministic && t < last; t++)
+        {
+            fields[t] = pairwiseFinish(&levels[(t - first) * levelCount], reductionBlocks);
+        }
+    }
+}
+
+FieldDerivatives ECE_FieldSolver::computeFieldDerivatives(double x, double y, double z,
+                                                          std::vector<WorkerStats> *stats) const
+{
+    if (deterministic)
+    {
+        // the same fixed blocks and pairwise tree as computeDirectField
+        std::size_t count = charges.size();
+        std::size_t blockCount = (count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+        std::vector<FieldDerivatives> partial(blockCount);
+        ECE_RangeScheduler scheduler(0, blockCount, numThreads,
+                                     ECE_RangeScheduler::adaptiveGrain(blockCount, numThreads, 8));
+#pragma omp parallel num_threads(numThreads)
+        scheduler.run(omp_get_thread_num(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t block = begin; block < end; block++)
+            {
+                sumFieldDerivativesAt(charges, block * REDUCTION_BLOCK, std::min((block + 1) * REDUCTION_BLOCK, count),
+                                      x, y, z, partial[block]);
+            }
+        });
+        if (stats)
+        {
+            *stats = scheduler.getStats();
+        }
+        return pairwiseSum(partial.data(), partial.size());
+    }
+
+    // one partial result per thread, added in thread order after the parallel region
+    std::vector<FieldDerivatives> partial(numThreads);
+    ECE_RangeScheduler scheduler(0, charges.size(), numThreads,
+                                 ECE_RangeScheduler::adaptiveGrain(charges.size(), numThreads, CHARGE_TILE));
+#pragma omp parallel num_threads(numThreads)
+    {
+        int thread = omp_get_thread_num();
+        scheduler.run(thread, [&](std::size_t begin, std::size_t end) {
+            sumFieldDerivativesAt(charges, begin, end, x, y, z, partial[thread]);
+        });
+    }
+    if (stats)
+    {
+        *stats = scheduler.getStats();
+    }
+    FieldDerivatives total;
+    for (const FieldDerivatives &value: partial)
+    {
+        addInPlace(total, value);
+    }
+    return total;
+}
+
+void ECE_FieldSolver::computeFieldDerivatives(const std::vector<FieldPoint> &targets,
+                                              std::vector<FieldDerivatives> &results) const
+{
+    results.assign(targets.size(), FieldDerivatives());
+    std::size_t blockCount = (targets.size() + TARGET_BLOCK - 1) / TARGET_BLOCK;
+    if (blockCount < static_cast<std::size_t>(numThreads))
+    {
+        for (std::size_t t = 0; t < targets.size(); t++)
+        {
+            results[t] = computeFieldDerivatives(targets[t].x, targets[t].y, targets[t].z);
+        }
+        return;
+    }
+
+    std::size_t chargeCount = charges.size();
+    std::size_t reductionBlocks = (chargeCount + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    std::size_t levelCount = pairwiseLevels(reductionBlocks);
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+    for (std::size_t block = 0; block < blockCount; block++)
+    {
+        std::size_t first = block * TARGET_BLOCK;
+        std::size_t last = std::min(first + TARGET_BLOCK, targets.size());
+        // deterministic mode feeds the block sums into the pairwise tree like computeFields
+        std::vector<FieldDerivatives> levels(deterministic ? (last - first) * levelCount : 0);
+        for (std::size_t tile = 0; tile < chargeCount; tile += CHARGE_TILE)
+        {
+            std::size_t tileEnd = std::min(tile + CHARGE_TILE, chargeCount);
+            for (std::size_t t = first; t < last; t++)
+            {
+                if (!deterministic)
+                {
+                    sumFieldDerivativesAt(charges, tile, tileEnd, targets[t].x, targets[t].y, targets[t].z,
+                                          results[t]);
+                    continue;
+                }
+                for (std::size_t begin = tile; begin < tileEnd; begin += REDUCTION_BLOCK)
+                {
+                    FieldDerivatives sum;
+                    sumFieldDerivativesAt(charges, begin, std::min(begin + REDUCTION_BLOCK, chargeCount),
+                                          targets[t].x, targets[t].y, targets[t].z, sum);
+                    pairwisePush(&levels[(t - first) * levelCount], begin / REDUCTION_BLOCK, sum);
+                }
+            }
+        }
+        for (std::size_t t = first; deterministic && t < last; t++)
+        {
+            results[t] = pairwiseFinish(&levels[(t - first) * levelCount], reductionBlocks);
+        }
+    }
+}
@@ -0,0 +1,225 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the class evaluating electric fields of a charge array at one or many targets
+ * */
+
+#ifndef LAB2_ECE_FIELDSOLVER_H
+#define LAB2_ECE_FIELDSOLVER_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_RangeScheduler.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+const std::size_t CHARGE_TILE = 2048;  // charges per tile, 64 KB of x, y, z, q that stay in cache
+const std::size_t TARGET_BLOCK = 64;   // targets evaluated against one tile before moving on
+const std::size_t REDUCTION_BLOCK = 256; // charges per leaf of the fixed reduction tree in deterministic mode
+
+/**
+ * @brief A point in space where the electric field is evaluated.
+ */
+struct FieldPoint
+{
+    double x; // x coordinate of the point
+    double y; // y coordinate of the point
+    double z; // z coordinate of the point
+};
+
+/**
+ * @brief The electric field vector at a point.
+ */
+struct FieldVector
+{
+    double Ex; // electric field in the x direction
+    double Ey; // electric field in the y direction
+    double Ez; // electric field in the z direction
+};
+
+/**
+ * @brief The electric potential, field and field gradient at a point.
+ */
+struct FieldDerivatives
+{
+    double potential = 0;        // electric potential in V, zero at infinity
+    double Ex = 0;               // electric field in the x direction
+    double Ey = 0;               // electric field in the y direction
+    double Ez = 0;               // electric field in the z direction
+    double gradient[3][3] = {};  // gradient[i][j] = dE_i / dx_j in V/m^2, symmetric and traceless
+};
+
+/**
+ * @brief Relative error of an approximate solver measured against the direct sum.
+ */
+struct FieldError
+{
+    double maxRelative; // largest |E_approx - E_direct| / |E_direct| over the samples
+    double rmsRelative; // root mean square of the same ratio
+};
+
+class ECE_BarnesHut;
+class ECE_FastMultipole;
+class ECE_CellList;
+enum class InteractionType;
+
+/**
+ * @brief A class to evaluate the electric field of a charge array.
+ *
+ * The charge array is built once by the caller and shared by every query,
+ * so neither a single target nor a batch of targets rebuilds the charges.
+ * By default the field is the exact direct sum, useBarnesHut and
+ * useFastMultipole switch to one of the tree approximations, and useCutoff
+ * to a short-range interaction over a spatial hash.
+ */
+class ECE_FieldSolver
+{
+protected:
+    const ECE_ChargeArray &charges;      // the charges producing the field
+    int numThreads;                      // number of OpenMP threads to use
+    std::unique_ptr<ECE_BarnesHut> tree; // Barnes-Hut tree, null unless in Barnes-Hut mode
+    std::unique_ptr<ECE_FastMultipole> fmm; // fast multipole engine, null unless in FMM mode
+    std::unique_ptr<ECE_CellList> cells; // spatial hash, null unless in cutoff mode
+    bool deterministic = false;          // fixed reduction order independent of the thread count
+    bool mixedPrecision = false;         // float kernel with a double fallback near charges
+    double nearDistanceSquared = 0;      // squared distance below which the mixed kernel falls back to double
+
+    FieldVector computeDirectField(double x, double y, double z, std::vector<WorkerStats> *stats) const;
+    void computeDirectFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const;
+public:
+    /**
+     * @brief Constructor for ECE_FieldSolver.
+     *
+     * @param charges the charges producing the field, must outlive the solver
+     * @param numThreads number of OpenMP threads to use
+     */
+    ECE_FieldSolver(const ECE_ChargeArray &charges, int numThreads);
+
+    ~ECE_FieldSolver();
+
+    /**
+     * @brief Switches the solver to the Barnes-Hut approximation.
+     *
+     * Builds an octree over the charges, which must not change afterwards.
+     *
+     * @param theta opening angle, 0 gives the exact sum and larger values are faster
+     */
+    void useBarnesHut(double theta);
+
+    /**
+     * @brief Switches the solver to the fast multipole method.
+     *
+     * Builds the octree of the charges and its multipole moments once, the charges must not
+     * change afterwards. Every query then only pays for the downward pass to its targets.
+     *
+     * @param order expansion order, higher is more accurate and slower
+     */
+    void useFastMultipole(int order);
+
+    /**
+     * @brief Switches the solver to a short-range interaction truncated at a cutoff radius.
+     *
+     * Hashes the charges into cells as wide as the cutoff, which must not change afterwards.
+     * Every target then only visits the 27 cells around it.
+     *
+     * @param cutoff radius beyond which charges are ignored
+     * @param type Coulomb or Yukawa-screened interaction
+     * @param screeningLength screening length of the Yukawa interaction, ignored for Coulomb
+     */
+    void useCutoff(double cutoff, InteractionType type, double screeningLength = 0);
+
+    /**
+     * @brief Switches the solver back to the exact direct sum.
+     */
+    void useDirectSum();
+
+    /**
+     * @brief Selects the reduction used by the direct sum.
+     *
+     * In deterministic mode every target, single or in a batch, field or derivatives, is summed
+     * over fixed blocks of REDUCTION_BLOCK charges whose results are combined by a fixed pairwise
+     * tree. The result is bit-for-bit the same for any number of threads and whichever path
+     * evaluated it, and much less sensitive to cancellation than one running sum.
+     *
+     * @param enabled true for the deterministic reduction, false for the fast one
+     */
+    void setDeterministic(bool enabled);
+
+    /**
+     * @brief Selects the precision of the direct sum kernel.
+     *
+     * The mixed-precision kernel evaluates the charges in float with twice the SIMD lanes and
+     * accumulates in double. Charges closer to the target than nearDistance are summed in double,
+     * so a target sitting almost on a charge keeps full accuracy for the term that dominates it.
+     *
+     * @param enabled true for the mixed-precision kernel, false for double only
+     * @param nearDistance fallback distance, 0 picks 1e-3 of the diagonal of the charges' bounding box
+     */
+    void setMixedPrecision(bool enabled, double nearDistance = 0);
+
+    /**
+     * @brief Computes the electric field at a single point.
+     *
+     * For the direct sum the charges are distributed over the threads by a work-stealing
+     * ECE_RangeScheduler and the partial sums are reduced, in Barnes-Hut mode the tree is walked by the calling thread and
+     * in FMM mode the point is evaluated as a batch of one. The solver keeps no state per query,
+     * so concurrent queries on one solver are safe.
+     *
+     * @param x x coordinate of the point
+     * @param y y coordinate of the point
+     * @param z z coordinate of the point
+     * @param stats if given, receives the per-thread statistics of the direct sum, empty in the other modes
+     * @return the electric field at the point
+     */
+    FieldVector computeField(double x, double y, double z, std::vector<WorkerStats> *stats = nullptr) const;
+
+    /**
+     * @brief Computes the electric field at a batch of points.
+     *
+     * Targets are processed in blocks of TARGET_BLOCK, in parallel over blocks. For the direct sum
+     * each block is swept over the charges one CHARGE_TILE at a time so the tile stays in cache.
+     * In FMM mode the whole batch is handed to the fast multipole engine.
+     *
+     * @param targets the points to evaluate
+     * @param fields the electric field at each point, resized to match targets
+     */
+    void computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields) const;
+
+    /**
+     * @brief Computes potential, field and field gradient at a single point with the direct sum.
+     *
+     * One pass over the charges, distributed over the threads like computeField, replaces the
+     * seven field evaluations of a central finite difference. The tree modes do not provide
+     * derivatives, so this always sums directly.
+     *
+     * @param x x coordinate of the point
+     * @param y y coordinate of the point
+     * @param z z coordinate of the point
+     * @param stats if given, receives the per-thread statistics of the sum
+     * @return the potential, field and gradient at the point
+     */
+    FieldDerivatives computeFieldDerivatives(double x, double y, double z,
+                                             std::vector<WorkerStats> *stats = nullptr) const;
+
+    /**
+     * @brief Computes potential, field and field gradient at a batch of points with the direct sum.
+     *
+     * Blocked over targets and charge tiles like computeFields.
+     *
+     * @param targets the points to evaluate
+     * @param results the derivatives at each point, resized to match targets
+     */
+    void computeFieldDerivatives(const std::vector<FieldPoint> &targets, std::vector<FieldDerivatives> &results) const;
+
+    /**
+     * @brief Measures the error of the current mode against the direct sum.
+     *
+     * @param samples the points at which both solutions are compared
+     * @return the maximum and root mean square relative error over the samples
+     */
+    FieldError measureError(const std::vector<FieldPoint> &samples) const;
+};
+
+
+#endif //LAB2_ECE_FIELDSOLVER_H
@@ -0,0 +1,117 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Implementation of thread pinning and NUMA page placement reports
+ * */
+
+#include "ECE_Numa.h"
+#include <cstdint>
+#include <iomanip>
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::vector<int> pinOpenMPThreads(int numThreads)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return {};
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    std::vector<int> binding(numThreads, -1);
+    bool pinned = !cpus.empty();
+#pragma omp parallel num_threads(numThreads) reduction(&&:pinned)
+    {
+        int thread = omp_get_thread_num();
+        if (!cpus.empty())
+        {
+            cpu_set_t single;
+            CPU_ZERO(&single);
+            CPU_SET(cpus[thread % cpus.size()], &single);
+            pinned = pthread_setaffinity_np(pthread_self(), sizeof(single), &single) == 0;
+            binding[thread] = cpus[thread % cpus.size()];
+        }
+    }
+    return pinned ? binding : std::vector<int>();
+}
+
+std::vector<std::size_t> pagesPerNode(const void *data, std::size_t bytes)
+{
+    std::vector<std::size_t> counts;
+#ifdef SYS_move_pages
+    const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const std::size_t batch = 4096; // pages per system call
+    auto first = reinterpret_cast<std::uintptr_t>(data) / pageSize * pageSize;
+    auto last = reinterpret_cast<std::uintptr_t>(data) + bytes;
+    std::vector<void *> pages;
+    std::vector<int> status;
+    for (std::uintptr_t page = first; page < last; page += batch * pageSize)
+    {
+        pages.clear();
+        for (std::uintptr_t address = page; address < last && pages.size() < batch; address += pageSize)
+        {
+            pages.push_back(reinterpret_cast<void *>(address));
+        }
+        status.assign(pages.size(), -1);
+        // without a node list move_pages only reports the node of each page
+        if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+        {
+            return {};
+        }
+        for (int node: status)
+        {
+            // negative entries are errors such as -ENOENT for a page that was never touched
+            if (node >= 0)
+            {
+                if (static_cast<std::size_t>(node) >= counts.size())
+                {
+                    counts.resize(node + 1);
+                }
+                counts[node]++;
+            }
+        }
+    }
+#endif
+    return counts;
+}
+
+void printMemoryPlacement(std::ostream &out, const ECE_ChargeArray &charges)
+{
+    const char *names[] = {"x", "y", "z", "q"};
+    const double *arrays[] = {charges.xData(), charges.yData(), charges.zData(), charges.qData()};
+    std::size_t bytes = charges.size() * sizeof(double);
+    for (int array = 0; array < 4; array++)
+    {
+        std::vector<std::size_t> counts = pagesPerNode(arrays[array], bytes);
+        std::size_t total = 0;
+        for (std::size_t count: counts)
+        {
+            total += count;
+        }
+        out << "Pages of " << names[array] << ":";
+        if (total == 0)
+        {
+            out << " placement unavailable" << std::endl;
+            continue;
+        }
+        for (std::size_t node = 0; node < counts.size(); node++)
+        {
+            out << " node " << node << " " << std::fixed << std::setprecision(1)
+                << 100.0 * counts[node] / total << "%" << (node + 1 < counts.size() ? "," : "");
+        }
+        out.unsetf(std::ios::floatfield);
+        out << " of " << total << " pages" << std::endl;
+    }
+}
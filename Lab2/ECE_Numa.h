@@ -0,0 +1,49 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for thread pinning and NUMA page placement reports
+ * */
+
+#ifndef LAB2_ECE_NUMA_H
+#define LAB2_ECE_NUMA_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Pins every thread of the OpenMP team to its own CPU.
+ *
+ * Thread t of a parallel region with numThreads threads is bound to the t-th CPU the process
+ * may run on, wrapping around if there are fewer CPUs than threads. OpenMP keeps its worker
+ * threads between regions, so the binding holds for the parallel regions that follow as
+ * long as they use the same number of threads.
+ *
+ * @param numThreads number of threads of the team to pin
+ * @return the CPU of each thread, empty if the affinity could not be set
+ */
+std::vector<int> pinOpenMPThreads(int numThreads);
+
+/**
+ * @brief Counts the resident pages of a memory range on each NUMA node.
+ *
+ * Queries the node of every page with move_pages(2) without moving anything.
+ *
+ * @param data the start of the range
+ * @param bytes the length of the range
+ * @return pages per node, indexed by node; empty if the kernel does not support the query
+ */
+std::vector<std::size_t> pagesPerNode(const void *data, std::size_t bytes);
+
+/**
+ * @brief Prints on which NUMA nodes the pages of each coordinate array of a charge collection lie.
+ *
+ * @param out the stream to print to
+ * @param charges the charge collection
+ */
+void printMemoryPlacement(std::ostream &out, const ECE_ChargeArray &charges);
+
+
+#endif //LAB2_ECE_NUMA_H
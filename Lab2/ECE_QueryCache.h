@@ -0,0 +1,169 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the bounded LRU cache of field queries shared by the interactive front ends
+ * */
+
+#ifndef LAB2_ECE_QUERYCACHE_H
+#define LAB2_ECE_QUERYCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+const std::size_t QUERY_CACHE_DEFAULT = 4096; // entries of the query cache when no capacity is given
+
+/**
+ * @brief A field query: the grid parameters and the target, compared bit for bit.
+ */
+struct GridQuery
+{
+    int N, M;                      // rows and columns of the grid
+    double xDistance, yDistance;   // spacing of the grid
+    double q;                      // charge on each point
+    double x, y, z;                // target point
+
+    bool operator==(const GridQuery &other) const
+    {
+        return N == other.N && M == other.M && xDistance == other.xDistance && yDistance == other.yDistance &&
+               q == other.q && x == other.x && y == other.y && z == other.z;
+    }
+
+    /**
+     * @brief Checks if two queries evaluate the same grid, so its charges can be reused.
+     */
+    bool sameGrid(const GridQuery &other) const
+    {
+        return N == other.N && M == other.M && xDistance == other.xDistance && yDistance == other.yDistance &&
+               q == other.q;
+    }
+};
+
+/**
+ * @brief Hash of a GridQuery, combining the hashes of its members like boost::hash_combine.
+ */
+struct GridQueryHash
+{
+    std::size_t operator()(const GridQuery &query) const
+    {
+        std::size_t seed = std::hash<int>()(query.N);
+        auto combine = [&seed](std::size_t value) {
+            seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        };
+        combine(std::hash<int>()(query.M));
+        for (double value: {query.xDistance, query.yDistance, query.q, query.x, query.y, query.z})
+        {
+            combine(std::hash<double>()(value));
+        }
+        return seed;
+    }
+};
+
+/**
+ * @brief Counters of a cache.
+ */
+struct CacheStats
+{
+    std::size_t hits = 0;      // lookups answered from the cache
+    std::size_t misses = 0;    // lookups that had to be computed
+    std::size_t evictions = 0; // entries dropped to stay within the capacity
+};
+
+/**
+ * @brief A bounded cache dropping the least recently used entry when full.
+ *
+ * The entries form a list in order of use, most recent first, and a hash map points into the
+ * list, so lookups, insertions and evictions take constant time.
+ *
+ * @tparam Key key type, needs operator==
+ * @tparam Value cached type
+ * @tparam Hash hash of the key
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ECE_LruCache
+{
+protected:
+    using Entry = std::pair<Key, Value>;
+
+    std::list<Entry> entries;                                          // most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index; // position of every key in entries
+    std::size_t capacity;                                              // maximum number of entries
+    CacheStats stats;                                                  // hit, miss and eviction counters
+public:
+    /**
+     * @brief Constructor for ECE_LruCache.
+     *
+     * @param capacity maximum number of entries, at least one
+     */
+    explicit ECE_LruCache(std::size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    /**
+     * @brief Looks up a key and marks it as most recently used, counting a hit or a miss.
+     *
+     * @param key the key
+     * @return the cached value, null on a miss; valid until the next insert
+     */
+    const Value *find(const Key &key)
+    {
+        auto found = index.find(key);
+        if (found == index.end())
+        {
+            stats.misses++;
+            return nullptr;
+        }
+        stats.hits++;
+        entries.splice(entries.begin(), entries, found->second);
+        return &found->second->second;
+    }
+
+    /**
+     * @brief Adds or replaces an entry, evicting the least recently used one if the cache is full.
+     *
+     * @param key the key
+     * @param value the value to cache
+     */
+    void insert(const Key &key, const Value &value)
+    {
+        auto found = index.find(key);
+        if (found != index.end())
+        {
+            found->second->second = value;
+            entries.splice(entries.begin(), entries, found->second);
+            return;
+        }
+        if (entries.size() == capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+            stats.evictions++;
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+    }
+
+    /**
+     * @brief Getter for the number of cached entries.
+     *
+     * @return the number of entries
+     */
+    std::size_t size() const
+    {
+        return entries.size();
+    }
+
+    /**
+     * @brief Getter for the hit, miss and eviction counters.
+     *
+     * @return the counters
+     */
+    const CacheStats &getStats() const
+    {
+        return stats;
+    }
+};
+
+
+#endif //LAB2_ECE_QUERYCACHE_H
@@ -0,0 +1,83 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: CPP file for the uniform N x M lattice of equal charges, generated on the fly
+ * */
+
+#include "ECE_UniformLattice.h"
+#include "ECE_ElectricField.h"
+#include <cmath>
+#include <omp.h>
+
+ECE_UniformLattice::ECE_UniformLattice(int N, int M, double xDistance, double yDistance, double q)
+        : N(N), M(M), xDistance(xDistance), yDistance(yDistance), q(q) {}
+
+void ECE_UniformLattice::sumRows(double x, double y, double z, int rowBegin, int rowEnd,
+                                 double &sumS, double &sumXS, double &sumYS) const
+{
+    // On a mirror plane only the first half of the rows/columns is visited and each of them
+    // stands in for its mirror image too, except the middle one of an odd count.
+    bool mirrorX = x == 0;
+    bool mirrorY = y == 0;
+    int columns = mirrorY ? (M + 1) / 2 : M;
+    double yOffset = (M - 1) / 2.0;
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        double dx = x - xDistance * (i - (N - 1) / 2.0);
+        double base = dx * dx + z * z;
+        double rowWeight = (mirrorX && 2 * i != N - 1) ? 2.0 : 1.0;
+
+        // s = 1 / r^3, summed alone for Ex and Ez and weighted by dy for Ey
+        double rowS = 0, rowYS = 0;
+#pragma omp simd reduction(+:rowS, rowYS)
+        for (int j = 0; j < columns; j++)
+        {
+            double dy = y - yDistance * (j - yOffset);
+            double r2 = base + dy * dy;
+            double s = 1 / (r2 * std::sqrt(r2));
+            double columnWeight = (mirrorY && 2 * j != M - 1) ? 2.0 : 1.0;
+            rowS += columnWeight * s;
+            rowYS += columnWeight * dy * s;
+        }
+        sumS += rowWeight * rowS;
+        sumXS += rowWeight * dx * rowS;
+        sumYS += rowWeight * rowYS;
+    }
+}
+
+FieldVector ECE_UniformLattice::finish(double z, bool mirrorX, bool mirrorY,
+                                       double sumS, double sumXS, double sumYS) const
+{
+    // the mirrored halves cancel exactly in the direction normal to the plane
+    return {mirrorX ? 0 : K * q * sumXS, mirrorY ? 0 : K * q * sumYS, K * q * z * sumS};
+}
+
+FieldVector ECE_UniformLattice::computeField(double x, double y, double z, int numThreads) const
+{
+    int rows = x == 0 ? (N + 1) / 2 : N;
+    double sumS = 0, sumXS = 0, sumYS = 0;
+#pragma omp parallel reduction(+:sumS, sumXS, sumYS) num_threads(numThreads)
+    {
+        int threadId = omp_get_thread_num();
+        int threadCount = omp_get_num_threads();
+        sumRows(x, y, z, static_cast<int>(static_cast<long long>(rows) * threadId / threadCount),
+                static_cast<int>(static_cast<long long>(rows) * (threadId + 1) / threadCount), sumS, sumXS, sumYS);
+    }
+    return finish(z, x == 0, y == 0, sumS, sumXS, sumYS);
+}
+
+void ECE_UniformLattice::computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields,
+                                       int numThreads) const
+{
+    fields.resize(targets.size());
+#pragma omp parallel for schedule(dynamic, TARGET_BLOCK) num_threads(numThreads)
+    for (std::size_t t = 0; t < targets.size(); t++)
+    {
+        const FieldPoint &target = targets[t];
+        double sumS = 0, sumXS = 0, sumYS = 0;
+        sumRows(target.x, target.y, target.z, 0, target.x == 0 ? (N + 1) / 2 : N, sumS, sumXS, sumYS);
+        fields[t] = finish(target.z, target.x == 0, target.y == 0, sumS, sumXS, sumYS);
+    }
+}
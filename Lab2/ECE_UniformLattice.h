@@ -0,0 +1,69 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Header file for the uniform N x M lattice of equal charges, generated on the fly
+ * */
+
+#ifndef LAB2_ECE_UNIFORMLATTICE_H
+#define LAB2_ECE_UNIFORMLATTICE_H
+
+#include "ECE_FieldSolver.h"
+#include <vector>
+
+/**
+ * @brief The lab's N x M grid of equal charges, described only by its parameters.
+ *
+ * Charge (i, j) sits at (xDistance * (i - (N - 1) / 2), yDistance * (j - (M - 1) / 2), 0)
+ * and carries q. Positions are generated inside the kernel, so no per-charge storage is
+ * needed. The lattice is symmetric under x -> -x and y -> -y, so for targets on one of
+ * these planes only half of the rows (or columns) are visited.
+ */
+class ECE_UniformLattice
+{
+protected:
+    int N;            // number of rows
+    int M;            // number of columns
+    double xDistance; // x distance between two adjacent points
+    double yDistance; // y distance between two adjacent points
+    double q;         // common charge on each point
+
+    void sumRows(double x, double y, double z, int rowBegin, int rowEnd,
+                 double &sumS, double &sumXS, double &sumYS) const;
+    FieldVector finish(double z, bool mirrorX, bool mirrorY, double sumS, double sumXS, double sumYS) const;
+public:
+    /**
+     * @brief Constructor for ECE_UniformLattice.
+     *
+     * @param N the number of rows in the grid
+     * @param M the number of columns in the grid
+     * @param xDistance the x distance between two adjacent points
+     * @param yDistance the y distance between two adjacent points
+     * @param q the common charge on each point
+     */
+    ECE_UniformLattice(int N, int M, double xDistance, double yDistance, double q);
+
+    /**
+     * @brief Computes the electric field at a single point, in parallel over the rows.
+     *
+     * @param x x coordinate of the point
+     * @param y y coordinate of the point
+     * @param z z coordinate of the point
+     * @param numThreads number of OpenMP threads to use
+     * @return the electric field at the point
+     */
+    FieldVector computeField(double x, double y, double z, int numThreads) const;
+
+    /**
+     * @brief Computes the electric field at a batch of points, in parallel over the points.
+     *
+     * @param targets the points to evaluate
+     * @param fields the electric field at each point, resized to match targets
+     * @param numThreads number of OpenMP threads to use
+     */
+    void computeFields(const std::vector<FieldPoint> &targets, std::vector<FieldVector> &fields,
+                       int numThreads) const;
+};
+
+
+#endif //LAB2_ECE_UNIFORMLATTICE_H
@@ -0,0 +1,190 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Benchmark comparing the fast multipole method and the incremental field cache with the direct OpenMP sum
+ * Run with: ./Lab2Bench [threads] [max grid side] [max targets] [expansion order]
+ * */
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "ECE_ChargeArray.h"
+#include "ECE_FastMultipole.h"
+#include "ECE_FieldCache.h"
+#include "ECE_FieldSolver.h"
+
+using namespace std;
+
+/**
+ * @brief Generates random targets in the slab above and below the grid.
+ *
+ * @param count the number of targets
+ * @param halfWidth half of the grid extent in x and y
+ * @return the targets
+ */
+vector<FieldPoint> makeTargets(size_t count, double halfWidth)
+{
+    mt19937 generator(6122);
+    uniform_real_distribution<double> planar(-halfWidth, halfWidth);
+    uniform_real_distribution<double> height(0.01, halfWidth);
+    vector<FieldPoint> targets(count);
+    for (auto &target: targets)
+    {
+        target = {planar(generator), planar(generator), height(generator)};
+    }
+    return targets;
+}
+
+/**
+ * @brief Largest relative difference between two field arrays.
+ *
+ * @param approx the approximate fields
+ * @param exact the reference fields
+ * @return max |approx - exact| / |exact|
+ */
+double maxRelativeError(const vector<FieldVector> &approx, const vector<FieldVector> &exact)
+{
+    double worst = 0;
+    for (size_t t = 0; t < exact.size(); t++)
+    {
+        double dx = approx[t].Ex - exact[t].Ex;
+        double dy = approx[t].Ey - exact[t].Ey;
+        double dz = approx[t].Ez - exact[t].Ez;
+        double norm = sqrt(exact[t].Ex * exact[t].Ex + exact[t].Ey * exact[t].Ey + exact[t].Ez * exact[t].Ez);
+        if (norm > 0)
+        {
+            worst = max(worst, sqrt(dx * dx + dy * dy + dz * dz) / norm);
+        }
+    }
+    return worst;
+}
+
+/**
+ * @brief Times incremental cache updates against full recomputes while a share of the charges moves.
+ *
+ * Every step moves the given share of randomly chosen charges by up to one grid spacing. After
+ * the last step the cached totals are compared with a fresh direct sum.
+ *
+ * @param numThreads number of OpenMP threads to use
+ * @param side grid side, the grid has side x side charges
+ * @param probeCount the number of probes
+ * @param spacing grid spacing
+ * @param q charge value
+ */
+void benchmarkFieldCache(int numThreads, int side, size_t probeCount, double spacing, double q)
+{
+    const int steps = 10;
+    const double movedShare = 0.02;
+
+    ECE_ChargeArray charges = ECE_ChargeArray::makeGrid(side, side, spacing, spacing, q);
+    vector<FieldPoint> probes = makeTargets(probeCount, side * spacing / 2);
+    double start = omp_get_wtime();
+    ECE_FieldCache cache(charges, probes, numThreads);
+    double fullTime = omp_get_wtime() - start;
+
+    mt19937 generator(6122);
+    uniform_int_distribution<size_t> pick(0, charges.size() - 1);
+    uniform_real_distribution<double> shift(-spacing, spacing);
+    size_t moved = max<size_t>(1, static_cast<size_t>(charges.size() * movedShare));
+    double updateTime = 0;
+    for (int step = 0; step < steps; step++)
+    {
+        // distinct indices, update() takes every charge at most once
+        vector<bool> taken(charges.size(), false);
+        vector<ChargeUpdate> updates;
+        while (updates.size() < moved)
+        {
+            size_t i = pick(generator);
+            if (!taken[i])
+            {
+                taken[i] = true;
+                updates.push_back({i, charges.xData()[i] + shift(generator), charges.yData()[i] + shift(generator),
+                                   charges.zData()[i], charges.qData()[i]});
+            }
+        }
+        start = omp_get_wtime();
+        cache.update(updates);
+        updateTime += omp_get_wtime() - start;
+    }
+
+    vector<FieldVector> exact;
+    ECE_FieldSolver solver(charges, numThreads);
+    solver.computeFields(probes, exact);
+
+    cout << endl << "field cache: " << charges.size() << " charges, " << probeCount << " probes, "
+         << moved << " charges moved per step" << endl;
+    cout << setw(14) << "full (s)" << setw(14) << "update (s)" << setw(10) << "speedup" << setw(14)
+         << "max rel err" << endl;
+    updateTime /= steps;
+    cout << fixed << setprecision(4) << setw(14) << fullTime << setw(14) << updateTime << setprecision(2)
+         << setw(10) << fullTime / updateTime << scientific << setprecision(2) << setw(14)
+         << maxRelativeError(cache.getFields(), exact) << endl;
+    cout.unsetf(ios::floatfield);
+}
+
+int main(int argc, char *argv[])
+{
+    int numThreads = omp_get_max_threads();
+    int maxSide = 400;
+    size_t maxTargets = 16000;
+    int order = FMM_DEFAULT_ORDER;
+    bool valid = argc <= 5;
+    try
+    {
+        numThreads = argc > 1 ? stoi(argv[1]) : numThreads;
+        maxSide = argc > 2 ? stoi(argv[2]) : maxSide;
+        maxTargets = argc > 3 ? stoul(argv[3]) : maxTargets;
+        order = argc > 4 ? stoi(argv[4]) : order;
+    }
+    catch (const logic_error &)
+    {
+        valid = false;
+    }
+    if (!valid || numThreads < 1 || maxSide < 1 || order < 1)
+    {
+        cerr << "Usage: " << argv[0] << " [threads] [max grid side] [max targets] [expansion order]" << endl;
+        return 1;
+    }
+
+    const double spacing = 0.01;
+    const double q = 1e-6;
+
+    cout << "threads = " << numThreads << ", expansion order = " << order << endl;
+    cout << setw(8) << "N x M" << setw(10) << "targets" << setw(14) << "direct (s)" << setw(14) << "FMM (s)"
+         << setw(10) << "speedup" << setw(14) << "max rel err" << endl;
+
+    for (int side = 50; side <= maxSide; side *= 2)
+    {
+        ECE_ChargeArray charges = ECE_ChargeArray::makeGrid(side, side, spacing, spacing, q);
+        ECE_FieldSolver solver(charges, numThreads);
+        for (size_t count = 1000; count <= maxTargets; count *= 4)
+        {
+            vector<FieldPoint> targets = makeTargets(count, side * spacing / 2);
+            vector<FieldVector> exact, approx;
+
+            solver.useDirectSum();
+            double start = omp_get_wtime();
+            solver.computeFields(targets, exact);
+            double directTime = omp_get_wtime() - start;
+
+            // the FMM time includes building the charge octree, the direct sum has nothing to build
+            start = omp_get_wtime();
+            solver.useFastMultipole(order);
+            solver.computeFields(targets, approx);
+            double fmmTime = omp_get_wtime() - start;
+
+            cout << setw(8) << side * side << setw(10) << count << fixed << setprecision(4) << setw(14)
+                 << directTime << setw(14) << fmmTime << setprecision(2) << setw(10) << directTime / fmmTime
+                 << scientific << setprecision(2) << setw(14) << maxRelativeError(approx, exact) << endl;
+            cout.unsetf(ios::floatfield);
+        }
+    }
+
+    benchmarkFieldCache(numThreads, maxSide, 2000, spacing, q);
+    return 0;
+}
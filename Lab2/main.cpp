@@ -1,10 +1,12 @@
 /*
  * Author: Shuojiang Liu
  * Class: ECE 6122
- * Last Date Modified: Oct 7, 2023
+ * Last Date Modified: Oct 18, 2026
  * Description: The main CPP file to calculate electric fields using multithreading
  * */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -12,6 +14,16 @@
 #include <iomanip>
 #include <omp.h>
 #include "ECE_ElectricField.h"
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldSolver.h"
+#include "ECE_UniformLattice.h"
+#include "ECE_CommandLine.h"
+#include "ECE_FieldMap.h"
+#include "ECE_Numa.h"
+#include "ECE_ChargeLoader.h"
+#include "ECE_CellList.h"
+#include "ECE_QueryCache.h"
+#include "ECE_PerfCounters.h"
 
 using namespace std;
 
@@ -126,77 +138,632 @@ bool checkOverlap(const double &xDist, const double &yDist, const double &xTarge
     return false;
 }
 
-int main()
+/**
+ * @brief Starts the performance counters of every thread of an OpenMP team.
+ *
+ * OpenMP reuses the threads of a team for the next parallel region with the same number of
+ * threads, so the solver's regions run on the threads counted here.
+ *
+ * @param numThreads number of threads of the team
+ */
+void startTeamCounters(int numThreads)
+{
+#pragma omp parallel num_threads(numThreads)
+    ECE_PerfCounters::thisThread().start();
+}
+
+/**
+ * @brief Stops the performance counters started by startTeamCounters.
+ *
+ * @param numThreads number of threads of the team
+ * @return the counts of every thread
+ */
+vector<PerfSample> stopTeamCounters(int numThreads)
+{
+    vector<PerfSample> samples(numThreads);
+#pragma omp parallel num_threads(numThreads)
+    samples[omp_get_thread_num()] = ECE_PerfCounters::thisThread().stop();
+    return samples;
+}
+
+int main(int argc, char *argv[])
 {
+    // Optional command line: -theta <opening angle> switches to the Barnes-Hut approximation,
+    // -fmm <expansion order> to the fast multipole method and -lattice to the storage-free lattice.
+    // -cutoff <radius> ignores charges farther away, using a spatial hash of the charges, and
+    // -yukawa <screening length> screens the interaction, with a default cutoff of 10 screening lengths.
+    // -stats prints the per-thread timing of the work-stealing direct sum after each query and
+    // -deterministic makes the direct sum bit-for-bit reproducible for any thread count.
+    // -mixed evaluates the direct sum in float, falling back to double close to a charge.
+    // -derivatives also prints the potential and the field gradient, summed directly in double in the same
+    // pass, so it cannot be combined with the approximate solvers or -mixed.
+    // -pin binds every solver thread to its own CPU and -numa fills the charges in parallel, so each
+    // page is first touched by the thread that sums it, then reports the NUMA node of the pages.
+    // -threads, -grid, -spacing and -charge answer the matching prompt, and every -point x y z
+    // is evaluated -repeat times without prompting, printing one CSV line per point.
+    // -volume x0 y0 z0 x1 y1 z1 nx ny nz -output <file> writes the field on a regular grid
+    // spanning the box to a raw binary file, or a NumPy file if the name ends in .npy.
+    // -charges <file> replaces the grid by a binary charge file, mapped without copying, or by a CSV
+    // file if the name ends in .csv; -generate <spec> by a lattice, random cloud or line of charges.
+    // -save-charges <file> writes the charges in use to a binary charge file for later runs.
+    // -cache <entries> answers repeated interactive queries from an LRU cache of computed fields, and
+    // -replay <file> evaluates a log of "N M x-spacing y-spacing charge x y z" lines through the cache,
+    // rebuilding the charges only when the grid changes.
+    // -perf reads cycles, instructions, cache misses and floating point instruction counters of every
+    // thread around each computation and prints them with the interactions per cycle and GFLOP/s.
+    // -config <file> reads the same options from a file, one per line without the dash.
+    vector<string> args;
+    string configError;
+    if (!expandConfigFiles(argc, argv, args, configError))
+    {
+        cerr << "Cannot read config file " << configError << endl;
+        return 1;
+    }
+    double theta = 0;
+    double cutoff = 0, screeningLength = 0;
+    int fmmOrder = 0;
+    bool useLattice = false;
+    bool printStats = false;
+    bool deterministic = false;
+    bool mixedPrecision = false;
+    bool derivatives = false;
+    bool pinThreads = false;
+    bool firstTouch = false;
+    bool profile = false;
+    int numThreadsInt = 0, N = 0, M = 0, repeat = 1;
+    double xDistance = 0, yDistance = 0, q = 0;
+    bool chargeGiven = false;
+    vector<FieldPoint> batchPoints;
+    vector<double> volume;  // box corners and resolution of the field map, empty if not requested
+    string outputFile;
+    string chargeFile;      // binary or CSV charge set replacing the grid
+    string generatorSpec;   // procedural charge set replacing the grid
+    string saveFile;        // binary charge file to write
+    string replayFile;      // query log to replay
+    size_t cacheCapacity = 0; // entries of the query cache, 0 disables it outside replay mode
+    bool validArguments = true;
+    for (size_t arg = 0; validArguments && arg < args.size(); arg++)
+    {
+        const string &option = args[arg];
+        if (option == "-lattice")
+        {
+            useLattice = true;
+            continue;
+        }
+        if (option == "-stats")
+        {
+            printStats = true;
+            continue;
+        }
+        if (option == "-deterministic")
+        {
+            deterministic = true;
+            continue;
+        }
+        if (option == "-mixed")
+        {
+            mixedPrecision = true;
+            continue;
+        }
+        if (option == "-derivatives")
+        {
+            derivatives = true;
+            continue;
+        }
+        if (option == "-pin")
+        {
+            pinThreads = true;
+            continue;
+        }
+        if (option == "-numa")
+        {
+            firstTouch = true;
+            continue;
+        }
+        if (option == "-perf")
+        {
+            profile = true;
+            continue;
+        }
+        size_t valueCount = (option == "-grid" || option == "-spacing") ? 2 : option == "-point" ? 3 :
+                            option == "-volume" ? 9 : 1;
+        if (arg + valueCount >= args.size())
+        {
+            validArguments = false;
+            break;
+        }
+        vector<string> values(args.begin() + arg + 1, args.begin() + arg + 1 + valueCount);
+        arg += valueCount;
+        if (option == "-theta" && isDouble(values[0]) && stod(values[0]) >= 0)
+        {
+            theta = stod(values[0]);
+        }
+        else if (option == "-cutoff" && isDouble(values[0]) && stod(values[0]) > 0)
+        {
+            cutoff = stod(values[0]);
+        }
+        else if (option == "-yukawa" && isDouble(values[0]) && stod(values[0]) > 0)
+        {
+            screeningLength = stod(values[0]);
+        }
+        else if (option == "-fmm" && isPositiveInteger(values[0]))
+        {
+            fmmOrder = stoi(values[0]);
+        }
+        else if (option == "-threads" && isPositiveInteger(values[0]))
+        {
+            numThreadsInt = stoi(values[0]);
+        }
+        else if (option == "-repeat" && isPositiveInteger(values[0]))
+        {
+            repeat = stoi(values[0]);
+        }
+        else if (option == "-charge" && isDouble(values[0]))
+        {
+            q = stod(values[0]) * 1e-6;
+            chargeGiven = true;
+        }
+        else if (option == "-grid" && isPositiveInteger(values[0]) && isPositiveInteger(values[1]))
+        {
+            N = stoi(values[0]);
+            M = stoi(values[1]);
+        }
+        else if (option == "-spacing" && isDouble(values[0]) && isDouble(values[1]) &&
+                 stod(values[0]) > 0 && stod(values[1]) > 0)
+        {
+            xDistance = stod(values[0]);
+            yDistance = stod(values[1]);
+        }
+        else if (option == "-point" && isDouble(values[0]) && isDouble(values[1]) && isDouble(values[2]))
+        {
+            batchPoints.push_back({stod(values[0]), stod(values[1]), stod(values[2])});
+        }
+        else if (option == "-volume" && all_of(values.begin(), values.begin() + 6, isDouble) &&
+                 all_of(values.begin() + 6, values.end(), isPositiveInteger))
+        {
+            volume.clear();
+            for (const string &value: values)
+            {
+                volume.push_back(stod(value));
+            }
+        }
+        else if (option == "-output")
+        {
+            outputFile = values[0];
+        }
+        else if (option == "-charges")
+        {
+            chargeFile = values[0];
+        }
+        else if (option == "-generate")
+        {
+            generatorSpec = values[0];
+        }
+        else if (option == "-save-charges")
+        {
+            saveFile = values[0];
+        }
+        else if (option == "-replay")
+        {
+            replayFile = values[0];
+        }
+        else if (option == "-cache" && isPositiveInteger(values[0]))
+        {
+            cacheCapacity = stoul(values[0]);
+        }
+        else
+        {
+            validArguments = false;
+        }
+    }
+    bool shortRange = cutoff > 0 || screeningLength > 0;
+    bool customCharges = !chargeFile.empty() || !generatorSpec.empty();
+    bool replay = !replayFile.empty();
+    if (!validArguments || (theta > 0) + (fmmOrder > 0) + useLattice + shortRange > 1 ||
+        volume.empty() != outputFile.empty() || (derivatives && (useLattice || shortRange || theta > 0 || fmmOrder > 0 || mixedPrecision)) ||
+        customCharges + useLattice > 1 || (replay && (customCharges || !volume.empty() || !batchPoints.empty())))
+    {
+        cerr << "Usage: " << argv[0] << " [-theta <opening angle> | -fmm <expansion order> | -lattice |"
+             << " -cutoff <radius> [-yukawa <screening length>]] [-stats]"
+             << " [-deterministic] [-mixed] [-derivatives] [-pin] [-numa] [-perf] [-threads <count>] [-grid <N> <M>] [-spacing <x> <y>]"
+             << " [-charge <micro C>] [-point <x> <y> <z>]... [-repeat <count>]"
+             << " [-volume <x0> <y0> <z0> <x1> <y1> <z1> <nx> <ny> <nz> -output <file>]"
+             << " [-charges <file> | -generate lattice|cloud|line,...] [-save-charges <file>]"
+             << " [-cache <entries>] [-replay <file>] [-config <file>]" << endl;
+        return 1;
+    }
+
     //query the user for how many threads to run concurrently when doing the calculation
-    cout << "Please enter the number of concurrent threads to use: ";
-    string numThreads;
-    getline(cin, numThreads);
-    while (!isPositiveInteger(numThreads))
+    if (numThreadsInt == 0)
     {
-        cout << "Invalid input. Please enter a positive integer: ";
+        cout << "Please enter the number of concurrent threads to use: ";
+        string numThreads;
         getline(cin, numThreads);
+        while (!isPositiveInteger(numThreads))
+        {
+            cout << "Invalid input. Please enter a positive integer: ";
+            getline(cin, numThreads);
+        }
+        numThreadsInt = stoi(numThreads);
     }
-    int numThreadsInt = stoi(numThreads);
+
+    // A loaded or generated charge set and a replayed log replace the grid prompts
+    bool promptGrid = !customCharges && !replay;
 
     // Prompt the user for the size of the array and make sure it is valid
-    cout << "Please enter the number of rows and columns in the N x M array: ";
-    string inputNM;
-    vector<string> inputNMVector;
-    getline(cin, inputNM);
-    while (!splitString(inputNM, inputNMVector, ' ', 2, false))
+    if (N == 0 && promptGrid)
     {
-        cout << "Invalid input. Please enter two positive integers separated by a space: ";
+        cout << "Please enter the number of rows and columns in the N x M array: ";
+        string inputNM;
+        vector<string> inputNMVector;
         getline(cin, inputNM);
-        inputNMVector.clear();
+        while (!splitString(inputNM, inputNMVector, ' ', 2, false))
+        {
+            cout << "Invalid input. Please enter two positive integers separated by a space: ";
+            getline(cin, inputNM);
+            inputNMVector.clear();
+        }
+        N = stoi(inputNMVector[0]);
+        M = stoi(inputNMVector[1]);
     }
-    int N = stoi(inputNMVector[0]);
-    int M = stoi(inputNMVector[1]);
 
     // Prompt the user for the separation distances and make sure it is valid
     // the x and y value must also be positive doubles
-    cout << "Please enter the x and y separation distances in meters: ";
-    string inputXY;
-    bool isPositive;  // check if x and y are positive doubles
-    vector<string> inputXYVector;
-    getline(cin, inputXY);
-    do
+    if (xDistance == 0 && promptGrid)
+    {
+        cout << "Please enter the x and y separation distances in meters: ";
+        string inputXY;
+        bool isPositive;  // check if x and y are positive doubles
+        vector<string> inputXYVector;
+        getline(cin, inputXY);
+        do
+        {
+            isPositive = true;
+            while (!splitString(inputXY, inputXYVector, ' ', 2, true))
+            {
+                cout << "Invalid input. Please enter two positive doubles separated by a space: ";
+                getline(cin, inputXY);
+                inputXYVector.clear();
+            }
+            for (const auto &i: inputXYVector)
+            {
+                if (stod(i) <= 0)
+                {
+                    isPositive = false;
+                    break;
+                }
+            }
+            if (!isPositive)
+            {
+                cout << "Invalid input. Please enter two positive doubles separated by a space: ";
+                getline(cin, inputXY);
+                inputXYVector.clear();
+            }
+        } while (!isPositive);
+        xDistance = stod(inputXYVector[0]) * 1.0;
+        yDistance = stod(inputXYVector[1]) * 1.0;
+    }
+
+    // Prompt the user for the electric charge and make sure it is valid
+    if (!chargeGiven && promptGrid)
+    {
+        cout << "Please enter the common charge_user on the points in micro C: ";
+        string inputQ;
+        getline(cin, inputQ);
+        while (!isDouble(inputQ))
+        {
+            cout << "Invalid input. Please enter a double: ";
+            getline(cin, inputQ);
+        }
+        q = stod(inputQ) * 1.0 * 1e-6;
+    }
+
+    // Build the charges once, every query below reuses them.
+    // The lattice generates the positions on the fly and needs no charge storage at all.
+    // Pinning comes first, so that the threads filling the charges are the ones summing them later.
+    ECE_ChargeArray charges;
+    if (pinThreads)
+    {
+        vector<int> binding = pinOpenMPThreads(numThreadsInt);
+        cout << (binding.empty() ? "Could not pin the threads" : "Pinned threads to CPUs");
+        for (int cpu: binding)
+        {
+            cout << " " << cpu;
+        }
+        cout << endl;
+    }
+    if (customCharges)
+    {
+        string loadError;
+        bool csv = chargeFile.size() >= 4 && chargeFile.compare(chargeFile.size() - 4, 4, ".csv") == 0;
+        double loadStart = omp_get_wtime();
+        bool loaded = !generatorSpec.empty() ? generateCharges(generatorSpec, charges, loadError, numThreadsInt) :
+                      csv ? loadChargeCsv(chargeFile, charges, loadError, numThreadsInt) :
+                      mapChargeFile(chargeFile, charges, loadError, numThreadsInt);
+        if (!loaded)
+        {
+            cerr << loadError << endl;
+            return 1;
+        }
+        cout << "Loaded " << charges.size() << " charges in " << fixed << setprecision(4)
+             << omp_get_wtime() - loadStart << " s" << endl;
+        cout.unsetf(ios::fixed);
+    }
+    else if (!useLattice && firstTouch)
+    {
+        charges = ECE_ChargeArray::makeGridFirstTouch(N, M, xDistance, yDistance, q, numThreadsInt);
+    }
+    else if (!useLattice)
+    {
+        charges = ECE_ChargeArray::makeGrid(N, M, xDistance, yDistance, q);
+    }
+    if (firstTouch && !useLattice)
+    {
+        printMemoryPlacement(cout, charges);
+    }
+    if (!saveFile.empty() && !saveChargeFile(saveFile, charges))
     {
-        isPositive = true;
-        while (!splitString(inputXY, inputXYVector, ' ', 2, true))
+        cerr << "Cannot write the charges to " << saveFile << endl;
+        return 1;
+    }
+    ECE_FieldSolver solver(charges, numThreadsInt);
+    solver.setDeterministic(deterministic);
+    solver.setMixedPrecision(mixedPrecision);
+    ECE_UniformLattice lattice(N, M, xDistance, yDistance, q);
+    // pairs evaluated per target, known only for the direct sum: the approximations and the mirror
+    // folding of the lattice skip a target-dependent share of them
+    double directPairs = useLattice || theta > 0 || fmmOrder > 0 || shortRange ? -1
+                                                                                : static_cast<double>(charges.size());
+    // Switches the solver to the requested approximation, replay mode repeats this for every new grid
+    auto selectMode = [&](ostream &out) {
+        if (theta > 0)
+        {
+            double buildStart = omp_get_wtime();
+            solver.useBarnesHut(theta);
+            double buildEnd = omp_get_wtime();
+            out << "Built the Barnes-Hut tree with theta = " << theta << " in " << fixed << setprecision(4)
+                 << (buildEnd - buildStart) * 1000000 << " microsec" << endl;
+            out.unsetf(ios::fixed);
+        }
+        else if (fmmOrder > 0)
         {
-            cout << "Invalid input. Please enter two positive doubles separated by a space: ";
-            getline(cin, inputXY);
-            inputXYVector.clear();
+            solver.useFastMultipole(fmmOrder);
+            out << "Using the fast multipole method with expansion order " << fmmOrder << endl;
         }
-        for (const auto &i: inputXYVector)
+        else if (shortRange)
         {
-            if (stod(i) <= 0)
+            if (cutoff == 0)
             {
-                isPositive = false;
-                break;
+                cutoff = YUKAWA_DEFAULT_CUTOFF * screeningLength;
             }
+            double buildStart = omp_get_wtime();
+            solver.useCutoff(cutoff, screeningLength > 0 ? InteractionType::Yukawa : InteractionType::Coulomb,
+                             screeningLength);
+            double buildEnd = omp_get_wtime();
+            out << "Hashed the charges into cells of " << cutoff << " m for the "
+                 << (screeningLength > 0 ? "Yukawa" : "Coulomb") << " cutoff in " << fixed << setprecision(4)
+                 << (buildEnd - buildStart) * 1000000 << " microsec" << endl;
+            out.unsetf(ios::fixed);
         }
-        if (!isPositive)
+    };
+    if (!replay)
+    {
+        selectMode(cout);
+    }
+
+    // Replay mode: every query goes through the cache, a miss rebuilds the grid only if it differs from the last one
+    ECE_LruCache<GridQuery, FieldVector, GridQueryHash> cache(cacheCapacity > 0 ? cacheCapacity : QUERY_CACHE_DEFAULT);
+    if (replay)
+    {
+        ifstream log(replayFile);
+        if (!log)
         {
-            cout << "Invalid input. Please enter two positive doubles separated by a space: ";
-            getline(cin, inputXY);
-            inputXYVector.clear();
+            cerr << "Cannot read query log " << replayFile << endl;
+            return 1;
+        }
+        cout << "N,M,dx,dy,q,x,y,z,Ex,Ey,Ez,E,cached,time_us" << endl;
+        GridQuery grid{};
+        size_t rebuilds = 0;
+        string line;
+        while (getline(log, line))
+        {
+            string content = line.substr(0, line.find('#'));
+            if (content.find_first_not_of(" \t\r") == string::npos)
+            {
+                continue;
+            }
+            istringstream tokens(content);
+            GridQuery query{};
+            double microCoulomb;
+            if (!(tokens >> query.N >> query.M >> query.xDistance >> query.yDistance >> microCoulomb >> query.x >> query.y >>
+                  query.z) || query.N <= 0 || query.M <= 0 || query.xDistance <= 0 || query.yDistance <= 0)
+            {
+                cerr << "Skipping malformed query: " << line << endl;
+                continue;
+            }
+            query.q = microCoulomb * 1e-6;
+            double start = omp_get_wtime();
+            const FieldVector *cached = cache.find(query);
+            FieldVector field = cached ? *cached : FieldVector{0, 0, 0};
+            if (!cached)
+            {
+                if (checkOverlap(query.xDistance, query.yDistance, query.x, query.y, query.z, query.N, query.M))
+                {
+                    cerr << "Skipping (" << query.x << ", " << query.y << ", " << query.z
+                         << "), it overlaps with the electric grids" << endl;
+                    continue;
+                }
+                if (rebuilds == 0 || !query.sameGrid(grid))
+                {
+                    grid = query;
+                    rebuilds++;
+                    lattice = ECE_UniformLattice(query.N, query.M, query.xDistance, query.yDistance, query.q);
+                    if (!useLattice)
+                    {
+                        charges = ECE_ChargeArray::makeGrid(query.N, query.M, query.xDistance, query.yDistance,
+                                                            query.q);
+                        solver.setMixedPrecision(mixedPrecision);
+                        selectMode(cerr);
+                    }
+                }
+                field = useLattice ? lattice.computeField(query.x, query.y, query.z, numThreadsInt)
+                                   : solver.computeField(query.x, query.y, query.z);
+                cache.insert(query, field);
+            }
+            double elapsed = (omp_get_wtime() - start) * 1000000;
+            cout << setprecision(10) << query.N << "," << query.M << "," << query.xDistance << "," << query.yDistance
+                 << "," << microCoulomb << "," << query.x << "," << query.y << "," << query.z << "," << field.Ex << ","
+                 << field.Ey << "," << field.Ez << ","
+                 << sqrt(field.Ex * field.Ex + field.Ey * field.Ey + field.Ez * field.Ez) << ","
+                 << (cached ? 1 : 0) << "," << setprecision(6) << elapsed << endl;
         }
-    } while (!isPositive);
-    double xDistance = stod(inputXYVector[0]) * 1.0;
-    double yDistance = stod(inputXYVector[1]) * 1.0;
+        const CacheStats &stats = cache.getStats();
+        cerr << "Query cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+             << " evictions, " << rebuilds << " grid builds" << endl;
+        return 0;
+    }
 
-    // Prompt the user for the electric charge and make sure it is valid
-    cout << "Please enter the common charge_user on the points in micro C: ";
-    string inputQ;
-    getline(cin, inputQ);
-    while (!isDouble(inputQ))
+    // Volume mode: stream the field map to the output file slab by slab
+    if (!volume.empty())
     {
-        cout << "Invalid input. Please enter a double: ";
-        getline(cin, inputQ);
+        ECE_FieldMap map({volume[0], volume[1], volume[2]}, {volume[3], volume[4], volume[5]},
+                         static_cast<int>(volume[6]), static_cast<int>(volume[7]), static_cast<int>(volume[8]));
+        bool npy = outputFile.size() >= 4 && outputFile.compare(outputFile.size() - 4, 4, ".npy") == 0;
+        if (profile)
+        {
+            startTeamCounters(numThreadsInt);
+        }
+        double start = omp_get_wtime();
+        bool written = map.write(outputFile, npy ? FieldMapFormat::Npy : FieldMapFormat::Raw,
+                                 [&](const vector<FieldPoint> &targets, vector<FieldVector> &fields) {
+                                     if (useLattice)
+                                     {
+                                         lattice.computeFields(targets, fields, numThreadsInt);
+                                     }
+                                     else
+                                     {
+                                         solver.computeFields(targets, fields);
+                                     }
+                                 }, numThreadsInt);
+        double end = omp_get_wtime();
+        if (!written)
+        {
+            cerr << "Cannot write the field map to " << outputFile << endl;
+            return 1;
+        }
+        cout << "Wrote " << map.voxelCount() << " voxels to " << outputFile << " in " << fixed << setprecision(4)
+             << end - start << " s (" << scientific << setprecision(3) << map.voxelCount() / (end - start)
+             << " voxels/s)" << endl;
+        if (profile)
+        {
+            printPerfReport(cout, stopTeamCounters(numThreadsInt), directPairs * map.voxelCount(), end - start);
+        }
+        return 0;
+    }
+
+    // Batch mode: evaluate the given points without prompting. Each point is timed repeat times,
+    // the throughput counts one pair interaction per charge and target and is left empty for
+    // the modes that skip pairs. FMM evaluates all points as one batch so the downward pass is
+    // shared, each row then reports the batch time divided by the number of points.
+    if (!batchPoints.empty())
+    {
+        cout << "x,y,z,Ex,Ey,Ez,E,mean_us,stddev_us,min_us,interactions_per_s"
+             << (derivatives ? ",V,dEx_dx,dEx_dy,dEx_dz,dEy_dy,dEy_dz,dEz_dz" : "") << endl;
+        vector<FieldPoint> points;
+        for (const FieldPoint &point: batchPoints)
+        {
+            if (!customCharges && checkOverlap(xDistance, yDistance, point.x, point.y, point.z, N, M))
+            {
+                cerr << "Skipping (" << point.x << ", " << point.y << ", " << point.z
+                     << "), it overlaps with the electric grids" << endl;
+                continue;
+            }
+            points.push_back(point);
+        }
+        vector<FieldVector> batchFields;
+        vector<double> batchSamples;
+        SampleSummary batchTime;
+        if (fmmOrder > 0 && !points.empty())
+        {
+            if (profile)
+            {
+                startTeamCounters(numThreadsInt);
+            }
+            for (int run = 0; run < repeat; run++)
+            {
+                double start = omp_get_wtime();
+                solver.computeFields(points, batchFields);
+                batchSamples.push_back((omp_get_wtime() - start) * 1000000 / points.size());
+            }
+            batchTime = summarizeSamples(batchSamples);
+            if (profile)
+            {
+                cerr << "Counters over " << points.size() << " points and " << repeat << " runs:" << endl;
+                printPerfReport(cerr, stopTeamCounters(numThreadsInt), directPairs * points.size() * repeat,
+                                batchTime.mean * points.size() * repeat * 1e-6);
+            }
+        }
+        for (size_t index = 0; index < points.size(); index++)
+        {
+            const FieldPoint &point = points[index];
+            FieldVector field = {0, 0, 0};
+            FieldDerivatives derived;
+            SampleSummary time;
+            if (!batchSamples.empty())
+            {
+                field = batchFields[index];
+                time = batchTime;
+            }
+            else
+            {
+                vector<double> samples;
+                if (profile)
+                {
+                    startTeamCounters(numThreadsInt);
+                }
+                for (int run = 0; run < repeat; run++)
+                {
+                    double start = omp_get_wtime();
+                    if (derivatives)
+                    {
+                        derived = solver.computeFieldDerivatives(point.x, point.y, point.z);
+                        field = {derived.Ex, derived.Ey, derived.Ez};
+                    }
+                    else
+                    {
+                        field = useLattice ? lattice.computeField(point.x, point.y, point.z, numThreadsInt)
+                                           : solver.computeField(point.x, point.y, point.z);
+                    }
+                    samples.push_back((omp_get_wtime() - start) * 1000000);
+                }
+                time = summarizeSamples(samples);
+                if (profile)
+                {
+                    // the CSV stays on standard output, the counters of all repeats go to standard error
+                    cerr << "Counters at (" << point.x << ", " << point.y << ", " << point.z << ") over " << repeat
+                         << " runs:" << endl;
+                    printPerfReport(cerr, stopTeamCounters(numThreadsInt), directPairs * repeat,
+                                    time.mean * repeat * 1e-6);
+                }
+            }
+            double absE = sqrt(field.Ex * field.Ex + field.Ey * field.Ey + field.Ez * field.Ez);
+            cout << setprecision(10) << point.x << "," << point.y << "," << point.z << "," << field.Ex << ","
+                 << field.Ey << "," << field.Ez << "," << absE << "," << setprecision(6) << time.mean << ","
+                 << time.stddev << "," << time.min << ",";
+            if (directPairs >= 0)
+            {
+                cout << directPairs / (time.mean * 1e-6);
+            }
+            if (derivatives)
+            {
+                cout << setprecision(10) << "," << derived.potential << "," << derived.gradient[0][0] << ","
+                     << derived.gradient[0][1] << "," << derived.gradient[0][2] << "," << derived.gradient[1][1]
+                     << "," << derived.gradient[1][2] << "," << derived.gradient[2][2];
+            }
+            cout << endl;
+        }
+        return 0;
     }
-    double q = stod(inputQ) * 1.0 * 1e-6;
 
     bool finish = false;
     while (!finish)
@@ -221,7 +788,7 @@ int main()
             x = stod(inputTargetVector[0]);
             y = stod(inputTargetVector[1]);
             z = stod(inputTargetVector[2]);
-            if (checkOverlap(xDistance, yDistance, x, y, z, N, M))
+            if (!customCharges && checkOverlap(xDistance, yDistance, x, y, z, N, M))
             {
                 isOverlap = true;
                 cout << "The point overlaps with the electric grids. Please enter another point: ";
@@ -230,18 +797,6 @@ int main()
             }
         } while (isOverlap);
 
-        // Create instances of ECE_ElectricField
-        vector<ECE_ElectricField> electricFields;
-        for (int i = 0; i < N; i++)
-        {
-            double xC = xDistance * (i - (N - 1) / 2.0);
-            for (int j = 0; j < M; j++)
-            {
-                double yC = yDistance * (j - (M - 1) / 2.0);
-                electricFields.emplace_back(xC, yC, 0, q);
-            }
-        }
-
         // Calculate overall electric field at the target point using OpenMP multithreading
         double Ex = 0;
         double Ey = 0;
@@ -257,47 +812,56 @@ int main()
 //            Ez += EzVal;
 //        }
 
+        if (profile)
+        {
+            startTeamCounters(numThreadsInt);
+        }
         double start = omp_get_wtime();
-#pragma omp parallel reduction(+:Ex, Ey, Ez) num_threads(numThreadsInt)
+        GridQuery query = {N, M, xDistance, yDistance, q, x, y, z};
+        // the derivatives kernel sums the field in the same pass, the cache only holds the field
+        FieldDerivatives derived;
+        vector<WorkerStats> workerStats;
+        const FieldVector *cached = cacheCapacity > 0 && !derivatives ? cache.find(query) : nullptr;
+        FieldVector field;
+        if (derivatives)
         {
-            double localEx = 0, localEy = 0, localEz = 0;
-            double ExVal, EyVal, EzVal;
-
-#pragma omp for
-            for (int i = 0; i < N * M; i++)
-            {
-                electricFields[i].computeFieldAt(x, y, z);
-                electricFields[i].getElectricField(ExVal, EyVal, EzVal);
-                localEx += ExVal;
-                localEy += EyVal;
-                localEz += EzVal;
-            }
-
-            Ex += localEx;
-            Ey += localEy;
-            Ez += localEz;
+            derived = solver.computeFieldDerivatives(x, y, z, &workerStats);
+            field = {derived.Ex, derived.Ey, derived.Ez};
+        }
+        else
+        {
+            field = cached ? *cached : useLattice ? lattice.computeField(x, y, z, numThreadsInt)
+                                                  : solver.computeField(x, y, z, &workerStats);
         }
+        if (cacheCapacity > 0 && !cached)
+        {
+            cache.insert(query, field);
+        }
+        Ex = field.Ex;
+        Ey = field.Ey;
+        Ez = field.Ez;
         double end = omp_get_wtime();
 
         cout << "The electric field at (" << x << ", " << y << ", " << z << ") in V/m is: " << endl;
 
+        // a component is exactly zero on a mirror plane of the lattice, log10 would be -inf
         int signEx = (Ex < 0) ? -1 : 1;
         double absEx = abs(Ex);
-        int exponentEx = static_cast<int>(floor(log10(absEx)));
+        int exponentEx = absEx > 0 ? static_cast<int>(floor(log10(absEx))) : 0;
         double mantissaEx = absEx / pow(10.0, exponentEx);
 
         int signEy = (Ey < 0) ? -1 : 1;
         double absEy = abs(Ey);
-        int exponentEy = static_cast<int>(floor(log10(absEy)));
+        int exponentEy = absEy > 0 ? static_cast<int>(floor(log10(absEy))) : 0;
         double mantissaEy = absEy / pow(10.0, exponentEy);
 
         int signEz = (Ez < 0) ? -1 : 1;
         double absEz = abs(Ez);
-        int exponentEz = static_cast<int>(floor(log10(absEz)));
+        int exponentEz = absEz > 0 ? static_cast<int>(floor(log10(absEz))) : 0;
         double mantissaEz = absEz / pow(10.0, exponentEz);
 
         double absE = sqrt(pow(Ex, 2) + pow(Ey, 2) + pow(Ez, 2));
-        int exponentE = static_cast<int>(floor(log10(absE)));
+        int exponentE = absE > 0 ? static_cast<int>(floor(log10(absE))) : 0;
         double mantissaE = absE / pow(10.0, exponentE);
 
         cout << "Ex = " << (signEx < 0 ? "-" : "")
@@ -308,7 +872,34 @@ int main()
              << fixed << setprecision(4) << mantissaEz << " * 10^" << exponentEz << endl;
         cout << "|E| = " << fixed << setprecision(4) << mantissaE << " * 10^" << exponentE << endl;
 
-        cout << "The calculation took " << setprecision(4) << (end - start) * 1000000 << " microsec!" << endl;
+        cout << "The calculation took " << setprecision(4) << (end - start) * 1000000 << " microsec!"
+             << (cached ? " (cached)" : "") << endl;
+        if (profile)
+        {
+            printPerfReport(cout, stopTeamCounters(numThreadsInt), cached ? 0 : directPairs, end - start);
+        }
+
+        // only a direct sum computed for this query reports worker statistics
+        if (printStats && !workerStats.empty())
+        {
+            printWorkerStats(cout, workerStats);
+        }
+        if (derivatives)
+        {
+            cout << "V = " << scientific << setprecision(4) << derived.potential << " V" << endl;
+            cout << "Field gradient dE_i/dx_j in V/m^2:" << endl;
+            for (const auto &row: derived.gradient)
+            {
+                cout << setw(14) << row[0] << setw(14) << row[1] << setw(14) << row[2] << endl;
+            }
+            cout.unsetf(ios::floatfield);
+        }
+        if (theta > 0 || fmmOrder > 0)
+        {
+            FieldError error = solver.measureError({{x, y, z}});
+            cout << "Relative error against the direct sum: " << scientific << setprecision(4)
+                 << error.maxRelative << endl;
+        }
 
         // Ask the user if they want to continue
         cout << "Do you want to enter a new location (Y/N)? ";
@@ -322,6 +913,12 @@ int main()
         if (inputContinue == "N" || inputContinue == "n")
         {
             finish = true;
+            if (cacheCapacity > 0)
+            {
+                const CacheStats &stats = cache.getStats();
+                cout << "Query cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                     << stats.evictions << " evictions" << endl;
+            }
             cout << "Bye!" << endl;
         }
     }
@@ -0,0 +1,196 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Batch front end of the hybrid MPI + OpenMP field solver
+ * Run with: mpirun -np <processes> ./Lab2MPI -grid <N> <M> [-spacing <x> <y>] [-charge <micro C>]
+ *           [-partition charges|targets] [-threads <count>] [-targets <count> | -point <x> <y> <z>...]
+ *           [-repeat <count>] [-verify] [-config <file>]
+ * */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <mpi.h>
+#include <omp.h>
+#include "ECE_CommandLine.h"
+#include "ECE_DistributedSolver.h"
+
+using namespace std;
+
+/**
+ * @brief Generates random targets in the slab above and below the grid, identical on every process.
+ *
+ * @param count the number of targets
+ * @param halfWidth half of the grid extent in x and y
+ * @return the targets
+ */
+vector<FieldPoint> makeRandomTargets(size_t count, double halfWidth)
+{
+    mt19937 generator(6122);
+    uniform_real_distribution<double> planar(-halfWidth, halfWidth);
+    uniform_real_distribution<double> height(0.01, halfWidth);
+    vector<FieldPoint> targets(count);
+    for (auto &target: targets)
+    {
+        target = {planar(generator), planar(generator), height(generator)};
+    }
+    return targets;
+}
+
+int main(int argc, char *argv[])
+{
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // every process parses the same command line, so no settings need to be broadcast
+    vector<string> args;
+    string configError;
+    bool validArguments = expandConfigFiles(argc, argv, args, configError);
+    PartitionMode mode = PartitionMode::Charges;
+    int numThreads = omp_get_max_threads(), N = 0, M = 0, repeat = 1;
+    double xDistance = 0.01, yDistance = 0.01, q = 1e-6;
+    size_t targetCount = 1000;
+    bool verify = false;
+    vector<FieldPoint> points;
+    try
+    {
+        for (size_t arg = 0; validArguments && arg < args.size(); arg++)
+        {
+            const string &option = args[arg];
+            size_t valueCount = option == "-verify" ? 0 : (option == "-grid" || option == "-spacing") ? 2 :
+                                option == "-point" ? 3 : 1;
+            if (arg + valueCount >= args.size())
+            {
+                validArguments = false;
+                break;
+            }
+            const string *values = &args[arg + 1];
+            arg += valueCount;
+            if (option == "-verify")
+            {
+                verify = true;
+            }
+            else if (option == "-partition" && (values[0] == "charges" || values[0] == "targets"))
+            {
+                mode = values[0] == "charges" ? PartitionMode::Charges : PartitionMode::Targets;
+            }
+            else if (option == "-threads")
+            {
+                numThreads = stoi(values[0]);
+            }
+            else if (option == "-repeat")
+            {
+                repeat = stoi(values[0]);
+            }
+            else if (option == "-targets")
+            {
+                targetCount = stoul(values[0]);
+            }
+            else if (option == "-charge")
+            {
+                q = stod(values[0]) * 1e-6;
+            }
+            else if (option == "-grid")
+            {
+                N = stoi(values[0]);
+                M = stoi(values[1]);
+            }
+            else if (option == "-spacing")
+            {
+                xDistance = stod(values[0]);
+                yDistance = stod(values[1]);
+            }
+            else if (option == "-point")
+            {
+                points.push_back({stod(values[0]), stod(values[1]), stod(values[2])});
+            }
+            else
+            {
+                validArguments = false;
+            }
+        }
+    }
+    catch (const logic_error &)
+    {
+        validArguments = false;
+    }
+    if (!validArguments || N <= 0 || M <= 0 || numThreads <= 0 || repeat <= 0 || xDistance <= 0 || yDistance <= 0)
+    {
+        if (rank == 0)
+        {
+            cerr << "Usage: mpirun -np <processes> " << argv[0] << " -grid <N> <M> [-spacing <x> <y>]"
+                 << " [-charge <micro C>] [-partition charges|targets] [-threads <count>]"
+                 << " [-targets <count> | -point <x> <y> <z>...] [-repeat <count>] [-verify] [-config <file>]"
+                 << endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    double buildStart = MPI_Wtime();
+    ECE_DistributedSolver solver(MPI_COMM_WORLD, mode, N, M, xDistance, yDistance, q, numThreads);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double buildTime = MPI_Wtime() - buildStart;
+
+    vector<FieldPoint> targets = points.empty() ? makeRandomTargets(targetCount, max(N * xDistance, M * yDistance) / 2)
+                                                : points;
+    vector<FieldVector> fields;
+    vector<double> samples;
+    for (int run = 0; run < repeat; run++)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start = MPI_Wtime();
+        solver.computeFields(targets, fields);
+        samples.push_back(MPI_Wtime() - start);
+    }
+
+    if (rank == 0)
+    {
+        SampleSummary time = summarizeSamples(samples);
+        double pairs = static_cast<double>(N) * M * targets.size();
+        cout << size << " processes x " << numThreads << " threads, "
+             << (mode == PartitionMode::Charges ? "charges" : "targets") << " partitioned, "
+             << solver.localChargeCount() << " charges on rank 0" << endl;
+        cout << "Grid built in " << fixed << setprecision(4) << buildTime << " s, " << targets.size()
+             << " targets in " << time.mean << " s (stddev " << time.stddev << " s), " << scientific
+             << setprecision(3) << pairs / time.mean << " interactions/s" << endl;
+        cout.unsetf(ios::floatfield);
+        if (!points.empty())
+        {
+            cout << "x,y,z,Ex,Ey,Ez" << endl;
+            for (size_t t = 0; t < targets.size(); t++)
+            {
+                cout << setprecision(10) << targets[t].x << "," << targets[t].y << "," << targets[t].z << ","
+                     << fields[t].Ex << "," << fields[t].Ey << "," << fields[t].Ez << endl;
+            }
+        }
+        if (verify)
+        {
+            // single-process reference on the whole grid, only sensible for grids that fit on one node
+            ECE_ChargeArray charges = ECE_ChargeArray::makeGrid(N, M, xDistance, yDistance, q);
+            ECE_FieldSolver reference(charges, numThreads);
+            vector<FieldVector> exact;
+            reference.computeFields(targets, exact);
+            double worst = 0;
+            for (size_t t = 0; t < targets.size(); t++)
+            {
+                double dx = fields[t].Ex - exact[t].Ex, dy = fields[t].Ey - exact[t].Ey, dz = fields[t].Ez - exact[t].Ez;
+                double norm = sqrt(exact[t].Ex * exact[t].Ex + exact[t].Ey * exact[t].Ey + exact[t].Ez * exact[t].Ez);
+                worst = max(worst, norm > 0 ? sqrt(dx * dx + dy * dy + dz * dz) / norm : 0);
+            }
+            cout << "Max relative difference to the single-process sum: " << scientific << setprecision(3) << worst
+                 << endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
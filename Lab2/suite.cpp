@@ -0,0 +1,323 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE 6122
+ * Last Date Modified: Oct 18, 2026
+ * Description: Benchmark suite sweeping grid sizes, target counts, thread counts and kernels
+ * Run with: ./Lab2Suite [-kernels direct,mixed,...] [-grids 100x100,...] [-targets 1,1024,...]
+ *           [-threads 1,2,4,...] [-repetitions <count>] [-min-time <seconds>] [-csv <file>] [-config <file>]
+ * */
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "ECE_ChargeArray.h"
+#include "ECE_CommandLine.h"
+#include "ECE_FastMultipole.h"
+#include "ECE_FieldSolver.h"
+#include "ECE_UniformLattice.h"
+
+using namespace std;
+
+/**
+ * @brief The settings of one sweep.
+ */
+struct SuiteOptions
+{
+    vector<string> kernels = {"direct", "mixed", "deterministic"};
+    vector<pair<int, int>> grids = {{100, 100}, {300, 300}, {1000, 1000}};
+    vector<size_t> targets = {1, 1024, 16384};
+    vector<int> threads;   // defaults to powers of two up to omp_get_max_threads()
+    int repetitions = 5;   // timing samples per benchmark
+    double minTime = 0.05; // each sample repeats the evaluation until this many seconds have passed
+    string csvFile;        // optional machine readable output
+};
+
+/**
+ * @brief Splits a comma separated list.
+ *
+ * @param list the list, e.g. "1,2,4"
+ * @return the entries
+ */
+vector<string> splitList(const string &list)
+{
+    vector<string> entries;
+    string entry;
+    istringstream stream(list);
+    while (getline(stream, entry, ','))
+    {
+        if (!entry.empty())
+        {
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+/**
+ * @brief Parses the expanded command line into the sweep settings.
+ *
+ * @param args the arguments after config file expansion
+ * @param options the settings to fill in
+ * @return false if an option is unknown or malformed
+ */
+bool parseOptions(const vector<string> &args, SuiteOptions &options)
+{
+    try
+    {
+        for (size_t arg = 0; arg + 1 < args.size(); arg += 2)
+        {
+            const string &option = args[arg];
+            vector<string> values = splitList(args[arg + 1]);
+            if (option == "-kernels")
+            {
+                options.kernels = values;
+            }
+            else if (option == "-grids")
+            {
+                options.grids.clear();
+                for (const string &grid: values)
+                {
+                    size_t separator = grid.find('x');
+                    if (separator == string::npos)
+                    {
+                        return false;
+                    }
+                    options.grids.emplace_back(stoi(grid.substr(0, separator)), stoi(grid.substr(separator + 1)));
+                }
+            }
+            else if (option == "-targets")
+            {
+                options.targets.clear();
+                for (const string &count: values)
+                {
+                    options.targets.push_back(stoul(count));
+                }
+            }
+            else if (option == "-threads")
+            {
+                options.threads.clear();
+                for (const string &count: values)
+                {
+                    options.threads.push_back(stoi(count));
+                }
+            }
+            else if (option == "-repetitions")
+            {
+                options.repetitions = stoi(args[arg + 1]);
+            }
+            else if (option == "-min-time")
+            {
+                options.minTime = stod(args[arg + 1]);
+            }
+            else if (option == "-csv")
+            {
+                options.csvFile = args[arg + 1];
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+    catch (const logic_error &)
+    {
+        return false;
+    }
+    return args.size() % 2 == 0 && options.repetitions > 0;
+}
+
+/**
+ * @brief Generates reproducible random targets in the slab above and below the grid.
+ *
+ * @param count the number of targets
+ * @param halfWidth half of the grid extent in x and y
+ * @return the targets
+ */
+vector<FieldPoint> makeSuiteTargets(size_t count, double halfWidth)
+{
+    mt19937 generator(6122);
+    uniform_real_distribution<double> planar(-halfWidth, halfWidth);
+    uniform_real_distribution<double> height(0.01, halfWidth);
+    vector<FieldPoint> targets(count);
+    for (auto &target: targets)
+    {
+        target = {planar(generator), planar(generator), height(generator)};
+    }
+    return targets;
+}
+
+/**
+ * @brief Times an evaluation like Google Benchmark does.
+ *
+ * After one warm-up call, every sample repeats the evaluation until minTime has passed and
+ * records the mean time of one evaluation.
+ *
+ * @param evaluate the evaluation to time
+ * @param repetitions number of samples
+ * @param minTime minimum duration of one sample in seconds
+ * @return seconds per evaluation, one entry per sample
+ */
+vector<double> timeSamples(const function<void()> &evaluate, int repetitions, double minTime)
+{
+    evaluate();
+    vector<double> samples;
+    for (int sample = 0; sample < repetitions; sample++)
+    {
+        long iterations = 0;
+        double start = omp_get_wtime(), elapsed;
+        do
+        {
+            evaluate();
+            iterations++;
+            elapsed = omp_get_wtime() - start;
+        } while (elapsed < minTime);
+        samples.push_back(elapsed / iterations);
+    }
+    return samples;
+}
+
+/**
+ * @brief Configures a solver for the named kernel.
+ *
+ * @param solver the solver to configure
+ * @param kernel direct, mixed, deterministic, barnes-hut or fmm
+ * @return false if the kernel name is unknown
+ */
+bool configureSolver(ECE_FieldSolver &solver, const string &kernel)
+{
+    if (kernel == "mixed")
+    {
+        solver.setMixedPrecision(true);
+    }
+    else if (kernel == "deterministic")
+    {
+        solver.setDeterministic(true);
+    }
+    else if (kernel == "barnes-hut")
+    {
+        solver.useBarnesHut(0.5);
+    }
+    else if (kernel == "fmm")
+    {
+        solver.useFastMultipole(FMM_DEFAULT_ORDER);
+    }
+    else if (kernel != "direct")
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> args;
+    string configError;
+    SuiteOptions options;
+    if (!expandConfigFiles(argc, argv, args, configError) || !parseOptions(args, options))
+    {
+        cerr << "Usage: " << argv[0] << " [-kernels direct,mixed,deterministic,barnes-hut,fmm,lattice]"
+             << " [-grids <N>x<M>,...] [-targets <count>,...] [-threads <count>,...] [-repetitions <count>]"
+             << " [-min-time <seconds>] [-csv <file>] [-config <file>]" << endl;
+        return 1;
+    }
+    if (options.threads.empty())
+    {
+        for (int count = 1; count < omp_get_max_threads(); count *= 2)
+        {
+            options.threads.push_back(count);
+        }
+        options.threads.push_back(omp_get_max_threads());
+    }
+
+    ofstream csv;
+    if (!options.csvFile.empty())
+    {
+        csv.open(options.csvFile);
+        csv << "name,kernel,N,M,targets,threads,repetitions,mean_s,stddev_s,min_s,"
+               "interactions_per_s,interactions_stddev,efficiency" << endl;
+    }
+
+    const double spacing = 0.01;
+    const double q = 1e-6;
+    cout << left << setw(52) << "Benchmark" << right << setw(14) << "Time (ms)" << setw(9) << "CV"
+         << setw(16) << "Interactions/s" << setw(12) << "Efficiency" << endl;
+    cout << string(103, '-') << endl;
+
+    for (const auto &grid: options.grids)
+    {
+        ECE_ChargeArray charges = ECE_ChargeArray::makeGrid(grid.first, grid.second, spacing, spacing, q);
+        ECE_UniformLattice lattice(grid.first, grid.second, spacing, spacing, q);
+        double pairsPerTarget = static_cast<double>(grid.first) * grid.second;
+        for (const string &kernel: options.kernels)
+        {
+            for (size_t count: options.targets)
+            {
+                vector<FieldPoint> targets = makeSuiteTargets(count, max(grid.first, grid.second) * spacing / 2);
+                double baseRate = 0;
+                int baseThreads = 0;
+                for (int numThreads: options.threads)
+                {
+                    ECE_FieldSolver solver(charges, numThreads);
+                    if (kernel != "lattice" && !configureSolver(solver, kernel))
+                    {
+                        cerr << "Unknown kernel " << kernel << endl;
+                        return 1;
+                    }
+                    vector<FieldVector> fields;
+                    auto evaluate = [&]() {
+                        if (kernel == "lattice")
+                        {
+                            lattice.computeFields(targets, fields, numThreads);
+                        }
+                        else if (count == 1)
+                        {
+                            fields.assign(1, solver.computeField(targets[0].x, targets[0].y, targets[0].z));
+                        }
+                        else
+                        {
+                            solver.computeFields(targets, fields);
+                        }
+                    };
+                    SampleSummary time = summarizeSamples(timeSamples(evaluate, options.repetitions,
+                                                                      options.minTime));
+
+                    // the throughput spread follows from the timing spread to first order
+                    double pairs = pairsPerTarget * count;
+                    double rate = pairs / time.mean;
+                    double rateStddev = pairs * time.stddev / (time.mean * time.mean);
+                    if (baseThreads == 0)
+                    {
+                        baseRate = rate;
+                        baseThreads = numThreads;
+                    }
+                    double efficiency = rate / baseRate * baseThreads / numThreads;
+
+                    ostringstream name;
+                    name << kernel << "/" << grid.first << "x" << grid.second << "/targets:" << count
+                         << "/threads:" << numThreads;
+                    cout << left << setw(52) << name.str() << right << fixed << setprecision(4) << setw(14)
+                         << time.mean * 1000 << setprecision(1) << setw(8) << 100 * time.stddev / time.mean << "%"
+                         << scientific << setprecision(3) << setw(16) << rate << fixed << setprecision(2)
+                         << setw(12) << efficiency << endl;
+                    cout.unsetf(ios::floatfield);
+
+                    if (csv.is_open())
+                    {
+                        csv << setprecision(9) << name.str() << "," << kernel << "," << grid.first << ","
+                            << grid.second << "," << count << "," << numThreads << "," << options.repetitions
+                            << "," << time.mean << "," << time.stddev << "," << time.min << "," << rate << ","
+                            << rateStddev << "," << efficiency << endl;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
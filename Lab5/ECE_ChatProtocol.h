@@ -0,0 +1,141 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * The wire format shared by the client and the server. Version 102 sends every message as the
+ * whole 1004-byte tcpMessage. Version 103 sends a 6-byte header (version, type, payload length
+ * as a 32-bit big-endian number) followed by exactly that many payload bytes. The first byte of
+ * every frame tells the two apart, so old clients keep working against the same server.
+ * Header-only, so the client still compiles from a single source file.
+ */
+
+#ifndef LAB5_ECE_CHATPROTOCOL_H
+#define LAB5_ECE_CHATPROTOCOL_H
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+const unsigned char LEGACY_VERSION = 102;
+const unsigned char COMPACT_VERSION = 103;
+const unsigned char TYPE_BROADCAST = 77;
+const unsigned char TYPE_REVERSE = 201;
+const std::size_t COMPACT_HEADER_SIZE = 6;
+const std::size_t MAX_MESSAGE_LENGTH = 1 << 20;   // longest payload accepted in a version 103 frame
+
+// The data being sent back and forth by version 102 clients
+struct tcpMessage
+{
+    unsigned char nVersion;
+    unsigned char nType;
+    unsigned short nMsgLen;
+    char chMsg[1000];
+};
+
+// A message independent of the frame it travelled in
+struct ChatMessage
+{
+    unsigned char nVersion = 0;
+    unsigned char nType = 0;
+    std::string text;
+};
+
+enum class FrameStatus
+{
+    Incomplete,     // more bytes are needed
+    Complete,       // one message was decoded
+    Invalid         // the stream cannot be parsed any further
+};
+
+/**
+ * @brief Encodes a message as a frame of the given wire version.
+ *
+ * Version 103 frames carry the whole text. Any other version gives a 1004-byte tcpMessage
+ * with that version, the text is cut to the 1000 bytes of chMsg.
+ *
+ * @param message the message
+ * @param version the wire version of the receiver
+ * @return the frame
+ */
+inline std::string encodeMessage(const ChatMessage &message, unsigned char version)
+{
+    if (version == COMPACT_VERSION)
+    {
+        std::string frame(COMPACT_HEADER_SIZE, '\0');
+        frame[0] = static_cast<char>(version);
+        frame[1] = static_cast<char>(message.nType);
+        std::uint32_t length = htonl(static_cast<std::uint32_t>(message.text.size()));
+        std::memcpy(&frame[2], &length, sizeof(length));
+        frame += message.text;
+        return frame;
+    }
+
+    tcpMessage legacy{};
+    legacy.nVersion = version;
+    legacy.nType = message.nType;
+    legacy.nMsgLen = static_cast<unsigned short>(std::min(message.text.size(), sizeof(legacy.chMsg)));
+    std::memcpy(legacy.chMsg, message.text.data(), legacy.nMsgLen);
+    return std::string(reinterpret_cast<const char *>(&legacy), sizeof(legacy));
+}
+
+/**
+ * @brief Decodes the frame at the start of a byte stream.
+ *
+ * A frame starting with version 103 is a compact frame, anything else is read as a whole
+ * tcpMessage so that messages with an unknown version are skipped the way version 102 always did.
+ *
+ * @param data the received bytes not yet decoded
+ * @param size the number of bytes
+ * @param message the decoded message
+ * @param frameSize the number of bytes the frame took, valid if the frame is complete
+ * @return whether a message was decoded, more bytes are needed or the stream is corrupt
+ */
+inline FrameStatus decodeFrame(const char *data, std::size_t size, ChatMessage &message, std::size_t &frameSize)
+{
+    if (size == 0)
+    {
+        return FrameStatus::Incomplete;
+    }
+
+    if (static_cast<unsigned char>(data[0]) == COMPACT_VERSION)
+    {
+        if (size < COMPACT_HEADER_SIZE)
+        {
+            return FrameStatus::Incomplete;
+        }
+        std::uint32_t length;
+        std::memcpy(&length, data + 2, sizeof(length));
+        length = ntohl(length);
+        if (length > MAX_MESSAGE_LENGTH)
+        {
+            return FrameStatus::Invalid;
+        }
+        if (size < COMPACT_HEADER_SIZE + length)
+        {
+            return FrameStatus::Incomplete;
+        }
+        message.nVersion = COMPACT_VERSION;
+        message.nType = static_cast<unsigned char>(data[1]);
+        message.text.assign(data + COMPACT_HEADER_SIZE, length);
+        frameSize = COMPACT_HEADER_SIZE + length;
+        return FrameStatus::Complete;
+    }
+
+    tcpMessage legacy;
+    if (size < sizeof(legacy))
+    {
+        return FrameStatus::Incomplete;
+    }
+    std::memcpy(&legacy, data, sizeof(legacy));
+    message.nVersion = legacy.nVersion;
+    message.nType = legacy.nType;
+    message.text.assign(legacy.chMsg, std::min<std::size_t>(legacy.nMsgLen, sizeof(legacy.chMsg)));
+    frameSize = sizeof(legacy);
+    return FrameStatus::Complete;
+}
+
+#endif //LAB5_ECE_CHATPROTOCOL_H
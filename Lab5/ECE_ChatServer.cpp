@@ -0,0 +1,371 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * The chat logic shared by the server transports.
+ */
+
+#include "ECE_ChatServer.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+int openReusePortListener(int port, std::string &error)
+{
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        error = std::string("socket error: ") + strerror(errno);
+        return -1;
+    }
+
+    // every worker binds its own listener to the same port, the kernel balances new connections
+    int enable = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0)
+    {
+        error = std::string("SO_REUSEPORT error: ") + strerror(errno);
+        close(listener);
+        return -1;
+    }
+
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(listener, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
+    {
+        error = std::string("bind error: ") + strerror(errno);
+        close(listener);
+        return -1;
+    }
+    if (listen(listener, SOMAXCONN) < 0)
+    {
+        error = std::string("listen error: ") + strerror(errno);
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+QueueResult ECE_Connection::queueFrame(const ECE_Frame &frame, const ECE_OutputLimits &limits)
+{
+    if (closed)
+    {
+        return QueueResult::Dropped;
+    }
+    if (congested && limits.policy != SlowConsumerPolicy::DropOldest)
+    {
+        // with the disconnect policy the socket is already shut down and only waits for its owner
+        droppedFrames += limits.policy == SlowConsumerPolicy::DropNewest;
+        return QueueResult::Dropped;
+    }
+
+    // A frame longer than the limit still goes out if nothing else is waiting. A queue the socket has not
+    // refused is only waiting for its owner's turn, e.g. a batch of the io_uring transport, not for the client.
+    if (refused && outputBytes > 0 && outputBytes + frame->size() > limits.highWatermark)
+    {
+        congestions++;
+        congested = true;
+        if (limits.policy == SlowConsumerPolicy::Disconnect)
+        {
+            // the owner sees the connection end and closes it, the descriptor stays valid until then
+            std::cout << "Client " << fd << " is not reading, disconnecting" << std::endl;
+            shutdown(fd, SHUT_RDWR);
+            return QueueResult::Overflow;
+        }
+        if (limits.policy == SlowConsumerPolicy::DropNewest)
+        {
+            droppedFrames++;
+            return QueueResult::Dropped;
+        }
+        // drop the oldest frames, except one the socket has already taken part of
+        std::size_t keep = outputOffset > 0 ? 1 : 0;
+        while (output.size() > keep && outputBytes + frame->size() > limits.lowWatermark)
+        {
+            auto oldest = output.begin() + keep;
+            outputBytes -= (*oldest)->size();
+            output.erase(oldest);
+            droppedFrames++;
+        }
+        congested = outputBytes + frame->size() > limits.lowWatermark;
+    }
+
+    output.push_back(frame);
+    outputBytes += frame->size();
+    peakOutputBytes = std::max(peakOutputBytes, outputBytes);
+    return QueueResult::Queued;
+}
+
+ECE_Frame ECE_Connection::takeFrame(const ECE_OutputLimits &limits)
+{
+    ECE_Frame frame = std::move(output.front());
+    output.pop_front();
+    outputOffset = 0;
+    outputBytes -= frame->size();
+    if (congested && outputBytes <= limits.lowWatermark)
+    {
+        congested = false;
+    }
+    return frame;
+}
+
+void ECE_Connection::writeOutput(const ECE_OutputLimits &limits)
+{
+    while (!closed && !output.empty())
+    {
+        iovec frames[WRITE_FRAMES];
+        int count = 0;
+        for (auto frame = output.begin(); frame != output.end() && count < WRITE_FRAMES; ++frame, count++)
+        {
+            std::size_t skip = count == 0 ? outputOffset : 0;
+            frames[count].iov_base = const_cast<char *>((*frame)->data() + skip);
+            frames[count].iov_len = (*frame)->size() - skip;
+        }
+        msghdr header{};
+        header.msg_iov = frames;
+        header.msg_iovlen = count;
+        ssize_t written = sendmsg(fd, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // EAGAIN leaves the rest to the owner, other errors end the connection in its event loop
+            refused = errno == EAGAIN || errno == EWOULDBLOCK;
+            break;
+        }
+        std::size_t offered = 0;
+        for (int f = 0; f < count; f++)
+        {
+            offered += frames[f].iov_len;
+        }
+        refused = static_cast<std::size_t>(written) < offered;
+
+        // release the frames written completely, their last reference may be this queue
+        std::size_t remaining = written;
+        while (remaining > 0)
+        {
+            std::size_t left = output.front()->size() - outputOffset;
+            if (remaining < left)
+            {
+                outputOffset += remaining;
+                break;
+            }
+            remaining -= left;
+            takeFrame(limits);
+            sentFrames++;
+        }
+    }
+}
+
+ECE_ChatServer::ECE_ChatServer() : clientSockets(std::make_shared<const ECE_ClientList>())
+{
+}
+
+void ECE_ChatServer::setOutputLimits(const ECE_OutputLimits &limits)
+{
+    outputLimits = limits;
+}
+
+const ECE_OutputLimits &ECE_ChatServer::getOutputLimits() const
+{
+    return outputLimits;
+}
+
+std::shared_ptr<const ECE_ClientList> ECE_ChatServer::getClients() const
+{
+    return std::atomic_load(&clientSockets);
+}
+
+void ECE_ChatServer::addClient(const std::shared_ptr<ECE_Connection> &connection)
+{
+    std::lock_guard<std::mutex> lock(clientListMutex);
+    auto clients = std::make_shared<ECE_ClientList>(*clientSockets);
+    if (clients->empty() || clients->back()->size() >= CLIENT_CHUNK_SIZE)
+    {
+        clients->push_back(std::make_shared<const ECE_ClientChunk>(1, connection));
+    }
+    else
+    {
+        auto last = std::make_shared<ECE_ClientChunk>(*clients->back());
+        last->push_back(connection);
+        clients->back() = last;
+    }
+    std::atomic_store(&clientSockets, std::shared_ptr<const ECE_ClientList>(clients));
+}
+
+void ECE_ChatServer::removeClient(const ECE_Connection *connection)
+{
+    std::lock_guard<std::mutex> lock(clientListMutex);
+    const ECE_ClientList &current = *clientSockets;
+    for (std::size_t c = 0; c < current.size(); c++)
+    {
+        const ECE_ClientChunk &chunk = *current[c];
+        for (std::size_t i = 0; i < chunk.size(); i++)
+        {
+            if (chunk[i].get() != connection)
+            {
+                continue;
+            }
+            // the last client of the last chunk fills the hole, so only the last chunk is ever partly empty
+            auto clients = std::make_shared<ECE_ClientList>(current);
+            auto last = std::make_shared<ECE_ClientChunk>(*current.back());
+            if (c + 1 == current.size())
+            {
+                (*last)[i] = last->back();
+            }
+            else
+            {
+                auto changed = std::make_shared<ECE_ClientChunk>(chunk);
+                (*changed)[i] = last->back();
+                (*clients)[c] = changed;
+            }
+            last->pop_back();
+            if (last->empty())
+            {
+                clients->pop_back();
+            }
+            else
+            {
+                clients->back() = last;
+            }
+            std::atomic_store(&clientSockets, std::shared_ptr<const ECE_ClientList>(clients));
+            return;
+        }
+    }
+}
+
+bool ECE_ChatServer::receive(const std::shared_ptr<ECE_Connection> &connection, const char *data, std::size_t length)
+{
+    // a stream socket may split or merge frames, only whole frames are handled and the rest waits for more bytes
+    std::vector<char> &input = connection->input;
+    input.insert(input.end(), data, data + length);
+    std::size_t consumed = 0, frameSize = 0;
+    ChatMessage message;
+    FrameStatus status;
+    while ((status = decodeFrame(input.data() + consumed, input.size() - consumed, message, frameSize)) ==
+           FrameStatus::Complete)
+    {
+        consumed += frameSize;
+        if (message.nVersion == LEGACY_VERSION || message.nVersion == COMPACT_VERSION)
+        {
+            connection->protocolVersion = message.nVersion;
+        }
+        handleMessage(connection, message);
+    }
+    input.erase(input.begin(), input.begin() + consumed);
+    if (status == FrameStatus::Invalid)
+    {
+        std::cerr << "Frame longer than " << MAX_MESSAGE_LENGTH << " bytes, closing the connection" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ECE_ChatServer::handleMessage(const std::shared_ptr<ECE_Connection> &from, ChatMessage &message)
+{
+    // update the last message
+    lastMessageMutex.lock();
+    lastMessage = message;
+    isLastMessageAvailable = true;
+    lastMessageMutex.unlock();
+
+    if (message.nVersion != LEGACY_VERSION && message.nVersion != COMPACT_VERSION)
+    {
+        std::cout << "Invalid version, message ignored" << std::endl;
+        return;
+    }
+
+    if (message.nType == TYPE_BROADCAST)
+    {
+        std::cout << "Broadcasting message: " << message.text << std::endl;
+        // each frame is encoded once, and only if some receiver speaks that version, then every
+        // queue shares it. The snapshot needs no lock, clients joining meanwhile miss this message.
+        std::shared_ptr<const ECE_ClientList> clients = getClients();
+        ECE_Frame legacyFrame, compactFrame;
+        for (const auto &chunk: *clients)
+        {
+            for (const auto &client: *chunk)
+            {
+                if (client == from)
+                {
+                    continue;
+                }
+                bool compact = client->protocolVersion == COMPACT_VERSION;
+                ECE_Frame &frame = compact ? compactFrame : legacyFrame;
+                if (!frame)
+                {
+                    frame = std::make_shared<const std::string>(
+                            encodeMessage(message, compact ? COMPACT_VERSION : LEGACY_VERSION));
+                }
+                client->owner->send(client, frame);
+            }
+        }
+    }
+    else if (message.nType == TYPE_REVERSE)
+    {
+        std::cout << "Reversing message: " << message.text << std::endl;
+        std::reverse(message.text.begin(), message.text.end());
+        from->owner->send(from, std::make_shared<const std::string>(encodeMessage(message, message.nVersion)));
+    }
+    else
+    {
+        std::cout << "Invalid type" << std::endl;
+    }
+}
+
+bool ECE_ChatServer::getLastMessage(ChatMessage &message)
+{
+    std::lock_guard<std::mutex> lock(lastMessageMutex);
+    message = lastMessage;
+    return isLastMessageAvailable;
+}
+
+void ECE_ChatServer::printClients(std::ostream &out)
+{
+    std::shared_ptr<const ECE_ClientList> clients = getClients();
+    std::size_t count = 0;
+    for (const auto &chunk: *clients)
+    {
+        count += chunk->size();
+    }
+    out << "Number of Clients: " << count << std::endl;
+    for (const auto &chunk: *clients)
+    {
+        for (const auto &client: *chunk)
+        {
+            std::lock_guard<std::mutex> outputLock(client->outputMutex);
+            out << "IP Address: " << inet_ntoa(client->address.sin_addr)
+                << " | Port: " << ntohs(client->address.sin_port) << " | Queued: " << client->output.size()
+                << " frames, " << client->outputBytes << " bytes (peak " << client->peakOutputBytes << ")"
+                << " | Sent: " << client->sentFrames << " | Dropped: " << client->droppedFrames
+                << " | Over high watermark: " << client->congestions << (client->congested ? " (now)" : "")
+                << std::endl;
+        }
+    }
+}
+
+void ECE_ChatServer::closeAll()
+{
+    std::shared_ptr<const ECE_ClientList> clients = getClients();
+    for (const auto &chunk: *clients)
+    {
+        for (const auto &client: *chunk)
+        {
+            std::lock_guard<std::mutex> outputLock(client->outputMutex);
+            if (!client->closed)
+            {
+                client->closed = true;
+                close(client->fd);
+            }
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * Header file for the chat logic shared by the server transports: the message format,
+ * the connections and the list of connected clients.
+ */
+
+#ifndef LAB5_ECE_CHATSERVER_H
+#define LAB5_ECE_CHATSERVER_H
+
+#include "ECE_ChatProtocol.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+const int SERVER_PORT = 9999;
+const std::size_t OUTPUT_HIGH_WATERMARK = 4 << 20;  // default queued bytes at which a client counts as too slow
+const std::size_t CLIENT_CHUNK_SIZE = 512;  // clients per chunk of the client list
+const int WRITE_FRAMES = 64;                // queued frames gathered into one direct sendmsg call
+
+// An encoded frame, shared by every connection it is queued on
+using ECE_Frame = std::shared_ptr<const std::string>;
+
+// Creates a non-blocking listening socket bound to the port with SO_REUSEPORT, -1 on failure.
+// Every worker of a transport binds its own, the kernel balances new connections between them.
+int openReusePortListener(int port, std::string &error);
+
+class ECE_ServerWorker;
+
+// What happens to a frame for a client whose output queue is over the high watermark
+enum class SlowConsumerPolicy
+{
+    DropOldest,     // drop queued frames from the front until the queue is under the low watermark
+    DropNewest,     // drop new frames until the queue drains to the low watermark
+    Disconnect      // close the connection
+};
+
+struct ECE_OutputLimits
+{
+    std::size_t highWatermark = OUTPUT_HIGH_WATERMARK;
+    std::size_t lowWatermark = OUTPUT_HIGH_WATERMARK / 2;
+    SlowConsumerPolicy policy = SlowConsumerPolicy::DropNewest;
+};
+
+enum class QueueResult
+{
+    Queued,         // the frame is queued
+    Dropped,        // the frame or older ones were dropped, or the connection is closed
+    Overflow        // the queue is full and the connection was shut down by the disconnect policy
+};
+
+// A connected client. The input is only touched by the worker owning the connection,
+// frames can be queued by any worker under outputMutex.
+struct ECE_Connection
+{
+    int fd = -1;
+    sockaddr_in address{};
+    ECE_ServerWorker *owner = nullptr;  // the worker whose event loop serves the socket
+    std::vector<char> input;            // bytes received but not yet parsed into messages
+    std::atomic<unsigned char> protocolVersion{LEGACY_VERSION};  // wire version of the last valid frame received
+
+    std::mutex outputMutex;
+    std::deque<ECE_Frame> output;       // frames waiting for the socket to become writable
+    std::size_t outputOffset = 0;       // bytes of the front frame already written
+    std::size_t outputBytes = 0;        // bytes of the frames in output
+    bool congested = false;             // over the high watermark and not yet drained to the low one
+    bool refused = false;               // the socket took less than offered since it last took everything
+    bool closed = false;                // set once the socket is closed, nothing may be sent afterwards
+
+    // counters shown by the clients command, guarded by outputMutex
+    std::uint64_t sentFrames = 0;       // frames written completely
+    std::uint64_t droppedFrames = 0;    // frames dropped by the slow consumer policy
+    std::uint64_t congestions = 0;      // times the queue went over the high watermark
+    std::size_t peakOutputBytes = 0;    // largest outputBytes seen
+
+    // Appends a frame with outputMutex held, applying the slow consumer policy if the queue is too long
+    // while the socket refuses bytes
+    QueueResult queueFrame(const ECE_Frame &frame, const ECE_OutputLimits &limits);
+
+    // Removes the front frame with outputMutex held, once it is written or handed to the kernel
+    ECE_Frame takeFrame(const ECE_OutputLimits &limits);
+
+    // Writes queued frames with outputMutex held until the queue is empty or the socket takes no more
+    void writeOutput(const ECE_OutputLimits &limits);
+};
+
+// A thread running an event loop over its share of the connections
+class ECE_ServerWorker
+{
+public:
+    virtual ~ECE_ServerWorker() = default;
+
+    // Queues a frame for a connection owned by this worker, callable from any thread
+    virtual void send(const std::shared_ptr<ECE_Connection> &connection, const ECE_Frame &frame) = 0;
+};
+
+// A transport: the worker threads serving the connections of a server
+class ECE_Reactor
+{
+public:
+    virtual ~ECE_Reactor() = default;
+
+    // Opens the listeners and starts the worker threads, returns false with a reason if the transport is unusable
+    virtual bool start(std::string &error) = 0;
+
+    // Waits for the worker threads, which only end with the process
+    virtual void join() = 0;
+};
+
+// The connected clients as a list of immutable chunks. A changed list shares every chunk it did not
+// touch with the list it replaces, so adding or removing a client copies one chunk and the chunk pointers.
+using ECE_ClientChunk = std::vector<std::shared_ptr<ECE_Connection>>;
+using ECE_ClientList = std::vector<std::shared_ptr<const ECE_ClientChunk>>;
+
+// The state shared by all workers: the connected clients and the last message
+class ECE_ChatServer
+{
+public:
+    ECE_ChatServer();
+
+    // Registers a freshly accepted connection
+    void addClient(const std::shared_ptr<ECE_Connection> &connection);
+
+    // Unregisters a connection before its owner closes it
+    void removeClient(const ECE_Connection *connection);
+
+    // Appends received bytes to the connection's input and handles every complete message,
+    // returns false if the stream is corrupt and the connection has to be closed
+    bool receive(const std::shared_ptr<ECE_Connection> &connection, const char *data, std::size_t length);
+
+    // Handles one message: broadcast for type 77, echo reversed for type 201. Every receiver
+    // gets the message in the wire version it last sent itself.
+    void handleMessage(const std::shared_ptr<ECE_Connection> &from, ChatMessage &message);
+
+    // Copies the last message received, returns false if there is none yet
+    bool getLastMessage(ChatMessage &message);
+
+    // Prints the number and addresses of the connected clients with their output queue counters
+    void printClients(std::ostream &out);
+
+    // Closes every client socket, used when the server exits
+    void closeAll();
+
+    // Sets the output queue limits, before the transport starts
+    void setOutputLimits(const ECE_OutputLimits &limits);
+
+    const ECE_OutputLimits &getOutputLimits() const;
+
+    // A snapshot of the connected clients, which stays valid and unchanged while it is held
+    std::shared_ptr<const ECE_ClientList> getClients() const;
+
+private:
+    // clientListMutex only orders the writers, readers load the current list without it
+    std::mutex clientListMutex, lastMessageMutex;
+    std::shared_ptr<const ECE_ClientList> clientSockets;
+    ChatMessage lastMessage;
+    bool isLastMessageAvailable = false;
+    ECE_OutputLimits outputLimits;
+};
+
+#endif //LAB5_ECE_CHATSERVER_H
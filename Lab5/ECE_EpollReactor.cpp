@@ -0,0 +1,215 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * The epoll transport of the server. Every socket is non-blocking and registered edge-triggered,
+ * so each readiness edge is drained until EAGAIN before the worker waits again.
+ */
+
+#include "ECE_EpollReactor.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ECE_EpollWorker::ECE_EpollWorker(ECE_ChatServer &server, int listener)
+    : server(server), listener(listener), epollFd(epoll_create1(EPOLL_CLOEXEC))
+{
+    // the listener is the only registration without a connection pointer
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = nullptr;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &event);
+}
+
+ECE_EpollWorker::~ECE_EpollWorker()
+{
+    close(epollFd);
+    close(listener);
+}
+
+void ECE_EpollWorker::run()
+{
+    epoll_event events[EPOLL_MAX_EVENTS];
+    while (true)
+    {
+        int count = epoll_wait(epollFd, events, EPOLL_MAX_EVENTS, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait error: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        for (int e = 0; e < count; e++)
+        {
+            if (events[e].data.ptr == nullptr)
+            {
+                acceptAll();
+                continue;
+            }
+
+            auto found = connections.find(static_cast<ECE_Connection *>(events[e].data.ptr));
+            if (found == connections.end())
+            {
+                continue;
+            }
+            std::shared_ptr<ECE_Connection> connection = found->second;
+            if (events[e].events & EPOLLIN)
+            {
+                readAll(connection);
+            }
+            if (events[e].events & (EPOLLERR | EPOLLHUP))
+            {
+                closeConnection(connection);
+            }
+            else if (events[e].events & EPOLLOUT)
+            {
+                // whatever is left after EAGAIN is written on the next EPOLLOUT edge,
+                // which edge-triggered mode reports once the socket buffer drains
+                std::lock_guard<std::mutex> lock(connection->outputMutex);
+                connection->writeOutput(server.getOutputLimits());
+            }
+        }
+    }
+}
+
+void ECE_EpollWorker::acceptAll()
+{
+    while (true)
+    {
+        sockaddr_in clientAddr{};
+        socklen_t clientAddrLen = sizeof(clientAddr);
+        int clientSocket = accept4(listener, (struct sockaddr *)&clientAddr, &clientAddrLen,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSocket < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                // e.g. EMFILE, the pending connection stays queued until descriptors are freed
+                std::cerr << "accept error: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<ECE_Connection>();
+        connection->fd = clientSocket;
+        connection->address = clientAddr;
+        connection->owner = this;
+        connections.emplace(connection.get(), connection);
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = connection.get();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &event) < 0)
+        {
+            std::cerr << "epoll_ctl error: " << strerror(errno) << std::endl;
+            connections.erase(connection.get());
+            close(clientSocket);
+            continue;
+        }
+        std::cout << "New connection from " << inet_ntoa(clientAddr.sin_addr) << ":" << ntohs(clientAddr.sin_port)
+                  << std::endl;
+        server.addClient(connection);
+    }
+}
+
+void ECE_EpollWorker::readAll(const std::shared_ptr<ECE_Connection> &connection)
+{
+    static thread_local char buffer[READ_CHUNK];
+    while (true)
+    {
+        ssize_t readSize = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (readSize > 0)
+        {
+            if (!server.receive(connection, buffer, readSize))
+            {
+                closeConnection(connection);
+                return;
+            }
+            continue;
+        }
+        if (readSize < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (readSize < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return;
+        }
+        if (readSize < 0)
+        {
+            std::cerr << "read error: " << strerror(errno) << std::endl;
+        }
+        closeConnection(connection);
+        return;
+    }
+}
+
+void ECE_EpollWorker::closeConnection(const std::shared_ptr<ECE_Connection> &connection)
+{
+    server.removeClient(connection.get());
+    {
+        std::lock_guard<std::mutex> lock(connection->outputMutex);
+        if (!connection->closed)
+        {
+            connection->closed = true;
+            std::cout << "Client " << connection->fd << " disconnected" << std::endl;
+            // closing the descriptor also removes it from the epoll set
+            close(connection->fd);
+        }
+    }
+    connections.erase(connection.get());
+}
+
+void ECE_EpollWorker::send(const std::shared_ptr<ECE_Connection> &connection, const ECE_Frame &frame)
+{
+    std::lock_guard<std::mutex> lock(connection->outputMutex);
+    if (connection->queueFrame(frame, server.getOutputLimits()) == QueueResult::Queued &&
+        connection->output.size() == 1)
+    {
+        connection->writeOutput(server.getOutputLimits());
+    }
+}
+
+ECE_EpollReactor::ECE_EpollReactor(ECE_ChatServer &server, int port, unsigned workerCount)
+    : server(server), port(port), workerCount(workerCount)
+{
+}
+
+bool ECE_EpollReactor::start(std::string &error)
+{
+    for (unsigned w = 0; w < workerCount; w++)
+    {
+        int listener = openReusePortListener(port, error);
+        if (listener < 0)
+        {
+            return false;
+        }
+        workers.push_back(std::make_unique<ECE_EpollWorker>(server, listener));
+    }
+    for (auto &worker: workers)
+    {
+        threads.emplace_back(&ECE_EpollWorker::run, worker.get());
+    }
+    return true;
+}
+
+void ECE_EpollReactor::join()
+{
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+}
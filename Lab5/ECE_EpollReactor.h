@@ -0,0 +1,67 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * Header file for the epoll transport of the server: a fixed set of worker threads, each with
+ * its own SO_REUSEPORT listener and edge-triggered event loop over non-blocking sockets.
+ */
+
+#ifndef LAB5_ECE_EPOLLREACTOR_H
+#define LAB5_ECE_EPOLLREACTOR_H
+
+#include "ECE_ChatServer.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const int EPOLL_MAX_EVENTS = 256;       // events handled per epoll_wait call
+const std::size_t READ_CHUNK = 65536;   // bytes read per recv call
+
+// One worker thread of the epoll transport. The kernel spreads incoming connections over the
+// listeners of all workers, and a connection stays with the worker that accepted it.
+class ECE_EpollWorker : public ECE_ServerWorker
+{
+public:
+    ECE_EpollWorker(ECE_ChatServer &server, int listener);
+    ~ECE_EpollWorker() override;
+
+    // Runs the event loop until the process exits
+    void run();
+
+    // Queues the frame and, if the queue was empty, writes as much as the socket takes right away.
+    // A non-empty queue is already waiting for EPOLLOUT, the owner writes it then.
+    void send(const std::shared_ptr<ECE_Connection> &connection, const ECE_Frame &frame) override;
+
+private:
+    void acceptAll();
+    void readAll(const std::shared_ptr<ECE_Connection> &connection);
+    void closeConnection(const std::shared_ptr<ECE_Connection> &connection);
+
+    ECE_ChatServer &server;
+    int listener;
+    int epollFd;
+    std::unordered_map<ECE_Connection *, std::shared_ptr<ECE_Connection>> connections;
+};
+
+// The epoll transport: starts the workers and their threads
+class ECE_EpollReactor : public ECE_Reactor
+{
+public:
+    ECE_EpollReactor(ECE_ChatServer &server, int port, unsigned workerCount);
+
+    bool start(std::string &error) override;
+
+    void join() override;
+
+private:
+    ECE_ChatServer &server;
+    int port;
+    unsigned workerCount;
+    std::vector<std::unique_ptr<ECE_EpollWorker>> workers;
+    std::vector<std::thread> threads;
+};
+
+#endif //LAB5_ECE_EPOLLREACTOR_H
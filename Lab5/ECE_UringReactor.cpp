@@ -0,0 +1,677 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * The io_uring transport of the server. One multishot accept per listener and one multishot recv
+ * per connection stay armed, so steady traffic needs no new requests except the sends. Sends are
+ * collected while a batch of completions is handled and reach the kernel with the next wait.
+ */
+
+#include "ECE_UringReactor.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace
+{
+// the low bits of user_data tell the kind of request, the rest is the connection pointer
+const std::uint64_t TAG_ACCEPT = 0;
+const std::uint64_t TAG_RECV = 1;
+const std::uint64_t TAG_SEND = 2;
+const std::uint64_t TAG_WAKEUP = 3;
+const std::uint64_t TAG_WRITABLE = 4;
+const std::uint64_t TAG_MASK = 7;
+const unsigned short BUFFER_GROUP = 0;
+
+std::uint64_t userData(ECE_UringConnection *connection, std::uint64_t tag)
+{
+    return reinterpret_cast<std::uintptr_t>(connection) | tag;
+}
+}
+
+bool uringSupported(std::string &reason)
+{
+    // multishot recv arrived in Linux 6.0, the rest of what is used here before it
+    utsname name{};
+    int major = 0, minor = 0;
+    if (uname(&name) < 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2 || major < 6)
+    {
+        reason = std::string("kernel ") + name.release + " has no multishot recv, Linux 6.0 or newer is needed";
+        return false;
+    }
+
+    // io_uring may still be compiled out, disabled by sysctl or blocked by a seccomp filter
+    io_uring_params params{};
+    int ringFd = syscall(__NR_io_uring_setup, 1, &params);
+    if (ringFd < 0)
+    {
+        reason = std::string("io_uring_setup failed: ") + strerror(errno);
+        return false;
+    }
+    close(ringFd);
+    return true;
+}
+
+ECE_UringWorker::ECE_UringWorker(ECE_ChatServer &server) : server(server)
+{
+}
+
+ECE_UringWorker::~ECE_UringWorker()
+{
+    if (sqes != nullptr)
+    {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != nullptr && cqRing != sqRing)
+    {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != nullptr)
+    {
+        munmap(sqRing, sqRingSize);
+    }
+    if (ringFd >= 0)
+    {
+        close(ringFd);
+    }
+    if (bufferRing != nullptr)
+    {
+        munmap(bufferRing, bufferRingSize);
+    }
+    if (eventFd >= 0)
+    {
+        close(eventFd);
+    }
+    if (listener >= 0)
+    {
+        close(listener);
+    }
+}
+
+bool ECE_UringWorker::init(int port, std::string &error)
+{
+    // a completion queue larger than the submission queue, a broadcast to many clients completes many sends
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_ENTRIES * 4;
+    ringFd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (ringFd < 0)
+    {
+        error = std::string("io_uring_setup failed: ") + strerror(errno);
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        sqRing = nullptr;
+        error = std::string("mapping the submission queue failed: ") + strerror(errno);
+        return false;
+    }
+    cqRing = sqRing;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+        {
+            cqRing = nullptr;
+            error = std::string("mapping the completion queue failed: ") + strerror(errno);
+            return false;
+        }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                           IORING_OFF_SQES);
+    if (sqeMemory == MAP_FAILED)
+    {
+        error = std::string("mapping the submission entries failed: ") + strerror(errno);
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqeMemory);
+
+    char *sq = static_cast<char *>(sqRing), *cq = static_cast<char *>(cqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+    // submission entry i always sits in slot i
+    for (unsigned i = 0; i < sqEntries; i++)
+    {
+        sqArray[i] = i;
+    }
+
+    // the kernel picks a free buffer from this ring for every chunk a multishot recv delivers
+    bufferRingSize = URING_BUFFER_COUNT * sizeof(io_uring_buf);
+    void *ringMemory = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMemory == MAP_FAILED)
+    {
+        error = std::string("allocating the buffer ring failed: ") + strerror(errno);
+        return false;
+    }
+    bufferRing = static_cast<io_uring_buf_ring *>(ringMemory);
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<std::uintptr_t>(bufferRing);
+    registration.ring_entries = URING_BUFFER_COUNT;
+    registration.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+    {
+        error = std::string("registering the buffer ring failed: ") + strerror(errno);
+        return false;
+    }
+    buffers.resize(static_cast<std::size_t>(URING_BUFFER_COUNT) * URING_BUFFER_SIZE);
+    for (unsigned bufferId = 0; bufferId < URING_BUFFER_COUNT; bufferId++)
+    {
+        recycleBuffer(bufferId);
+    }
+
+    eventFd = eventfd(0, EFD_CLOEXEC);
+    if (eventFd < 0)
+    {
+        error = std::string("eventfd failed: ") + strerror(errno);
+        return false;
+    }
+
+    listener = openReusePortListener(port, error);
+    return listener >= 0;
+}
+
+io_uring_sqe *ECE_UringWorker::getSqe()
+{
+    while (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+    {
+        // The queue is full, hand what is there to the kernel first. It refuses with EBUSY while its
+        // completions have nowhere to go, so they are moved out of the ring to be handled by run().
+        if (!enter(0))
+        {
+            std::exit(EXIT_FAILURE);
+        }
+        reapCompletions();
+    }
+    io_uring_sqe *sqe = &sqes[sqLocalTail & *sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqLocalTail++;
+    return sqe;
+}
+
+void ECE_UringWorker::reapCompletions()
+{
+    unsigned head = *cqHead, tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        completions.push_back(cqes[head & *cqMask]);
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+bool ECE_UringWorker::enter(unsigned waitCount)
+{
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (syscall(__NR_io_uring_enter, ringFd, toSubmit, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0,
+                nullptr, 0) < 0)
+    {
+        // EBUSY means completions have to be reaped before more can be submitted
+        if (errno == EINTR || errno == EBUSY || errno == EAGAIN)
+        {
+            return true;
+        }
+        std::cerr << "io_uring_enter error: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ECE_UringWorker::armAccept()
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = userData(nullptr, TAG_ACCEPT);
+    acceptActive = true;
+}
+
+void ECE_UringWorker::armRecv(ECE_UringConnection &connection)
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = userData(&connection, TAG_RECV);
+    connection.recvActive = true;
+}
+
+void ECE_UringWorker::armWakeup()
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = eventFd;
+    sqe->addr = reinterpret_cast<std::uintptr_t>(&wakeupValue);
+    sqe->len = sizeof(wakeupValue);
+    sqe->user_data = userData(nullptr, TAG_WAKEUP);
+}
+
+void ECE_UringWorker::recycleBuffer(unsigned short bufferId)
+{
+    // only addr, len and bid are written, the resv field of entry 0 holds the ring tail. The entries are
+    // indexed from the start of the ring, in C++ the flexible bufs member of the kernel header is misplaced.
+    io_uring_buf &entry = reinterpret_cast<io_uring_buf *>(bufferRing)[bufferTail & (URING_BUFFER_COUNT - 1)];
+    entry.addr = reinterpret_cast<std::uintptr_t>(buffers.data() + static_cast<std::size_t>(bufferId) * URING_BUFFER_SIZE);
+    entry.len = URING_BUFFER_SIZE;
+    entry.bid = bufferId;
+    bufferTail++;
+    __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
+
+void ECE_UringWorker::send(const std::shared_ptr<ECE_Connection> &connection, const ECE_Frame &frame)
+{
+    auto &uringConnection = static_cast<ECE_UringConnection &>(*connection);
+    {
+        std::lock_guard<std::mutex> lock(connection->outputMutex);
+        const ECE_OutputLimits &limits = server.getOutputLimits();
+        // the owner may just not have had its turn yet, writing here keeps the order while it has no send in flight
+        if (!uringConnection.kernelSending && connection->outputBytes + frame->size() > limits.highWatermark)
+        {
+            connection->writeOutput(limits);
+        }
+        if (connection->queueFrame(frame, limits) != QueueResult::Queued)
+        {
+            return;
+        }
+    }
+
+    bool wakeup = false;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (!uringConnection.queued)
+        {
+            uringConnection.queued = true;
+            pendingSends.push_back(std::static_pointer_cast<ECE_UringConnection>(connection));
+            // the owner drains the list before every wait, it only sleeps if the list was empty
+            wakeup = pendingSends.size() == 1 && std::this_thread::get_id() != loopThread;
+        }
+    }
+    if (wakeup)
+    {
+        eventfd_write(eventFd, 1);
+    }
+}
+
+void ECE_UringWorker::submitPendingSends()
+{
+    std::vector<std::shared_ptr<ECE_UringConnection>> pending;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.swap(pendingSends);
+        for (auto &connection: pending)
+        {
+            connection->queued = false;
+        }
+    }
+    for (auto &connection: pending)
+    {
+        startSend(*connection);
+    }
+}
+
+void ECE_UringWorker::startSend(ECE_UringConnection &connection)
+{
+    // one send in flight per socket keeps the bytes in order, whatever arrives meanwhile goes out with the next one
+    if (connection.sendActive || connection.closing)
+    {
+        return;
+    }
+    std::size_t skip;
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        skip = connection.outputOffset;
+        while (!connection.output.empty() && connection.sending.size() < URING_SEND_FRAMES)
+        {
+            connection.sending.push_back(connection.takeFrame(server.getOutputLimits()));
+        }
+        connection.kernelSending = !connection.sending.empty();
+    }
+    if (connection.sending.empty())
+    {
+        return;
+    }
+    connection.sendingParts.clear();
+    for (const auto &frame: connection.sending)
+    {
+        connection.sendingParts.push_back({const_cast<char *>(frame->data()), frame->size()});
+    }
+    // a direct write may have taken the start of the first frame
+    connection.sendingParts[0].iov_base = static_cast<char *>(connection.sendingParts[0].iov_base) + skip;
+    connection.sendingParts[0].iov_len -= skip;
+    connection.sendingFirst = 0;
+    submitSendmsg(connection);
+}
+
+void ECE_UringWorker::submitSendmsg(ECE_UringConnection &connection)
+{
+    connection.sendingHeader = msghdr{};
+    connection.sendingHeader.msg_iov = connection.sendingParts.data() + connection.sendingFirst;
+    connection.sendingHeader.msg_iovlen = connection.sendingParts.size() - connection.sendingFirst;
+
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = connection.fd;
+    sqe->addr = reinterpret_cast<std::uintptr_t>(&connection.sendingHeader);
+    sqe->len = 1;
+    // a full socket ends the request with a short count or EAGAIN instead of parking it in the kernel
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+    sqe->user_data = userData(&connection, TAG_SEND);
+    connection.sendActive = true;
+}
+
+void ECE_UringWorker::armWritable(ECE_UringConnection &connection)
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = connection.fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = userData(&connection, TAG_WRITABLE);
+    connection.sendActive = true;
+}
+
+void ECE_UringWorker::run()
+{
+    loopThread = std::this_thread::get_id();
+    armWakeup();
+    armAccept();
+    while (true)
+    {
+        // the sends queued while handling the last batch are submitted together with the wait,
+        // which is skipped if submitting them already had to reap completions
+        submitPendingSends();
+        if (!enter(completions.empty() ? 1 : 0))
+        {
+            return;
+        }
+
+        // handling a completion may reap more when the submission queue fills up, they join this batch
+        reapCompletions();
+        for (std::size_t c = 0; c < completions.size(); c++)
+        {
+            io_uring_cqe cqe = completions[c];
+            handleCompletion(cqe);
+            // Sends are submitted as soon as the completion that queued them is handled and their own
+            // completions join the batch. Left for the end of the batch, the frames would count as
+            // backlog against the watermarks of readers that keep up.
+            submitPendingSends();
+            if (sqLocalTail != *sqTail)
+            {
+                if (!enter(0))
+                {
+                    return;
+                }
+                reapCompletions();
+            }
+        }
+        completions.clear();
+    }
+}
+
+void ECE_UringWorker::handleCompletion(const io_uring_cqe &cqe)
+{
+    std::uint64_t tag = cqe.user_data & TAG_MASK;
+    auto *connection = reinterpret_cast<ECE_UringConnection *>(cqe.user_data & ~TAG_MASK);
+    if (tag == TAG_ACCEPT)
+    {
+        handleAccept(cqe.res, cqe.flags & IORING_CQE_F_MORE);
+    }
+    else if (tag == TAG_WAKEUP)
+    {
+        armWakeup();
+    }
+    else if (tag == TAG_RECV)
+    {
+        handleRecv(*connection, cqe);
+    }
+    else if (tag == TAG_WRITABLE)
+    {
+        handleWritable(*connection);
+    }
+    else
+    {
+        handleSend(*connection, cqe.res);
+    }
+}
+
+void ECE_UringWorker::handleAccept(int result, bool more)
+{
+    if (!more)
+    {
+        acceptActive = false;
+    }
+    if (result < 0)
+    {
+        std::cerr << "accept error: " << strerror(-result) << std::endl;
+        // out of descriptors, accepting resumes once a connection is closed
+        if (!acceptActive && result != -EMFILE && result != -ENFILE)
+        {
+            armAccept();
+        }
+        return;
+    }
+
+    auto connection = std::make_shared<ECE_UringConnection>();
+    connection->fd = result;
+    connection->owner = this;
+    socklen_t addressLength = sizeof(connection->address);
+    getpeername(result, (struct sockaddr *)&connection->address, &addressLength);
+    connections.emplace(connection.get(), connection);
+    std::cout << "New connection from " << inet_ntoa(connection->address.sin_addr) << ":"
+              << ntohs(connection->address.sin_port) << std::endl;
+    server.addClient(connection);
+    armRecv(*connection);
+
+    if (!acceptActive)
+    {
+        armAccept();
+    }
+}
+
+void ECE_UringWorker::handleRecv(ECE_UringConnection &connection, const io_uring_cqe &cqe)
+{
+    bool corrupt = false;
+    if (cqe.flags & IORING_CQE_F_BUFFER)
+    {
+        auto bufferId = static_cast<unsigned short>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (cqe.res > 0 && !connection.closing)
+        {
+            auto found = connections.find(&connection);
+            corrupt = !server.receive(found->second,
+                                      buffers.data() + static_cast<std::size_t>(bufferId) * URING_BUFFER_SIZE, cqe.res);
+        }
+        recycleBuffer(bufferId);
+    }
+
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more)
+    {
+        connection.recvActive = false;
+    }
+    if (connection.closing)
+    {
+        if (!connection.recvActive && !connection.sendActive)
+        {
+            finishClose(connection);
+        }
+        return;
+    }
+    if (corrupt || cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS))
+    {
+        if (cqe.res < 0)
+        {
+            std::cerr << "read error: " << strerror(-cqe.res) << std::endl;
+        }
+        closeConnection(connection);
+        return;
+    }
+    // the kernel ends a multishot recv when the buffer ring runs dry, the buffers are back by now
+    if (!more)
+    {
+        armRecv(connection);
+    }
+}
+
+void ECE_UringWorker::handleSend(ECE_UringConnection &connection, int result)
+{
+    connection.sendActive = false;
+    if (connection.closing || (result < 0 && result != -EAGAIN))
+    {
+        connection.sending.clear();
+        if (!connection.closing)
+        {
+            closeConnection(connection);
+        }
+        else if (!connection.recvActive)
+        {
+            finishClose(connection);
+        }
+        return;
+    }
+
+    // skip the frames written completely
+    std::size_t written = result < 0 ? 0 : result;
+    while (connection.sendingFirst < connection.sendingParts.size() &&
+           written >= connection.sendingParts[connection.sendingFirst].iov_len)
+    {
+        written -= connection.sendingParts[connection.sendingFirst].iov_len;
+        connection.sendingFirst++;
+    }
+    if (connection.sendingFirst < connection.sendingParts.size())
+    {
+        // The socket is full. The rest goes back to the front of the queue, where the slow consumer
+        // policy sees it like the epoll transport does, and is sent again once the socket is writable.
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        const ECE_Frame &first = connection.sending[connection.sendingFirst];
+        std::size_t offset = first->size() - (connection.sendingParts[connection.sendingFirst].iov_len - written);
+        for (std::size_t f = connection.sending.size(); f > connection.sendingFirst; f--)
+        {
+            connection.outputBytes += connection.sending[f - 1]->size();
+            connection.output.push_front(std::move(connection.sending[f - 1]));
+        }
+        connection.outputOffset = offset;
+        connection.sentFrames += connection.sendingFirst;
+        connection.kernelSending = false;
+        connection.refused = true;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        connection.sentFrames += connection.sending.size();
+        connection.refused = false;
+    }
+    bool full = connection.sendingFirst < connection.sendingParts.size();
+    connection.sending.clear();
+    if (full)
+    {
+        armWritable(connection);
+        return;
+    }
+    startSend(connection);
+}
+
+void ECE_UringWorker::handleWritable(ECE_UringConnection &connection)
+{
+    connection.sendActive = false;
+    if (connection.closing)
+    {
+        if (!connection.recvActive)
+        {
+            finishClose(connection);
+        }
+        return;
+    }
+    startSend(connection);
+}
+
+void ECE_UringWorker::closeConnection(ECE_UringConnection &connection)
+{
+    connection.closing = true;
+    server.removeClient(&connection);
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        connection.closed = true;
+    }
+    std::cout << "Client " << connection.fd << " disconnected" << std::endl;
+    // in-flight requests hold their own reference to the socket, shutting it down ends them
+    shutdown(connection.fd, SHUT_RDWR);
+    if (!connection.recvActive && !connection.sendActive)
+    {
+        finishClose(connection);
+    }
+}
+
+void ECE_UringWorker::finishClose(ECE_UringConnection &connection)
+{
+    close(connection.fd);
+    connections.erase(&connection);
+    if (!acceptActive)
+    {
+        armAccept();
+    }
+}
+
+ECE_UringReactor::ECE_UringReactor(ECE_ChatServer &server, int port, unsigned workerCount)
+    : server(server), port(port), workerCount(workerCount)
+{
+}
+
+bool ECE_UringReactor::start(std::string &error)
+{
+    if (!uringSupported(error))
+    {
+        return false;
+    }
+    for (unsigned w = 0; w < workerCount; w++)
+    {
+        workers.push_back(std::make_unique<ECE_UringWorker>(server));
+        if (!workers.back()->init(port, error))
+        {
+            return false;
+        }
+    }
+    for (auto &worker: workers)
+    {
+        threads.emplace_back(&ECE_UringWorker::run, worker.get());
+    }
+    return true;
+}
+
+void ECE_UringReactor::join()
+{
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Author: Shuojiang Liu
+ * Class: ECE6122
+ * Last Date Modified: Oct 18, 2026
+ * Description:
+ * Header file for the io_uring transport of the server, driven through the raw system calls:
+ * multishot accept, multishot recv into a ring of provided buffers, and sends batched so that
+ * a broadcast reaches the kernel as one submission.
+ */
+
+#ifndef LAB5_ECE_URINGREACTOR_H
+#define LAB5_ECE_URINGREACTOR_H
+
+#include "ECE_ChatServer.h"
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const unsigned URING_ENTRIES = 4096;         // submission queue entries per worker
+const unsigned URING_BUFFER_COUNT = 64;      // provided receive buffers per worker, a power of two
+const unsigned URING_BUFFER_SIZE = 16384;    // bytes per provided receive buffer
+const std::size_t URING_SEND_FRAMES = 1024;  // queued frames gathered into one sendmsg request, at most IOV_MAX
+
+// Checks whether the kernel offers everything the io_uring transport needs, returns false with a reason
+bool uringSupported(std::string &reason);
+
+// A connection of the io_uring transport. The send state is only touched by the owning worker.
+struct ECE_UringConnection : ECE_Connection
+{
+    std::vector<ECE_Frame> sending;   // frames handed to the kernel, kept alive until the send completes
+    std::vector<iovec> sendingParts;  // the unwritten part of every frame in sending
+    std::size_t sendingFirst = 0;     // first entry of sendingParts not completely written
+    msghdr sendingHeader{};
+    bool sendActive = false;        // a send or the wait for the socket to become writable is in flight
+    bool recvActive = false;        // the multishot recv is armed
+    bool closing = false;           // shut down, the descriptor is closed once nothing is in flight
+    bool queued = false;            // listed in the worker's pending sends, guarded by pendingMutex
+    bool kernelSending = false;     // a send request holds frames of this connection, guarded by outputMutex
+};
+
+// One worker thread of the io_uring transport with its own ring and SO_REUSEPORT listener
+class ECE_UringWorker : public ECE_ServerWorker
+{
+public:
+    explicit ECE_UringWorker(ECE_ChatServer &server);
+    ~ECE_UringWorker() override;
+
+    // Sets up the ring and the buffer ring, then opens the listener, returns false with a reason on failure
+    bool init(int port, std::string &error);
+
+    // Runs the event loop until the process exits
+    void run();
+
+    // Queues the frame. The sends of a completion batch are submitted together with the next
+    // io_uring_enter, a call from another worker wakes the owner through an eventfd. A queue about
+    // to cross the high watermark is first written directly if the kernel holds nothing of it, so
+    // the slow consumer policy only sees bytes the socket refused, as with the epoll transport.
+    void send(const std::shared_ptr<ECE_Connection> &connection, const ECE_Frame &frame) override;
+
+private:
+    io_uring_sqe *getSqe();
+    bool enter(unsigned waitCount);
+    void reapCompletions();
+    void armAccept();
+    void armRecv(ECE_UringConnection &connection);
+    void armWakeup();
+    void startSend(ECE_UringConnection &connection);
+    void submitSendmsg(ECE_UringConnection &connection);
+    void armWritable(ECE_UringConnection &connection);
+    void submitPendingSends();
+    void recycleBuffer(unsigned short bufferId);
+    void handleCompletion(const io_uring_cqe &cqe);
+    void handleAccept(int result, bool more);
+    void handleRecv(ECE_UringConnection &connection, const io_uring_cqe &cqe);
+    void handleSend(ECE_UringConnection &connection, int result);
+    void handleWritable(ECE_UringConnection &connection);
+    void closeConnection(ECE_UringConnection &connection);
+    void finishClose(ECE_UringConnection &connection);
+
+    ECE_ChatServer &server;
+    int listener = -1;
+    int ringFd = -1;
+    int eventFd = -1;
+    std::thread::id loopThread;
+
+    // rings shared with the kernel
+    void *sqRing = nullptr, *cqRing = nullptr;
+    std::size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned sqEntries = 0, sqLocalTail = 0;
+    std::vector<io_uring_cqe> completions;  // taken from the completion queue but not yet handled
+
+    // receive buffers provided to the kernel
+    io_uring_buf_ring *bufferRing = nullptr;
+    std::size_t bufferRingSize = 0;
+    std::vector<char> buffers;
+    unsigned short bufferTail = 0;
+
+    bool acceptActive = false;
+    std::uint64_t wakeupValue = 0;
+    std::unordered_map<ECE_UringConnection *, std::shared_ptr<ECE_UringConnection>> connections;
+
+    std::mutex pendingMutex;
+    std::vector<std::shared_ptr<ECE_UringConnection>> pendingSends;
+};
+
+// The io_uring transport: starts the workers and their threads
+class ECE_UringReactor : public ECE_Reactor
+{
+public:
+    ECE_UringReactor(ECE_ChatServer &server, int port, unsigned workerCount);
+
+    bool start(std::string &error) override;
+
+    void join() override;
+
+private:
+    ECE_ChatServer &server;
+    int port;
+    unsigned workerCount;
+    std::vector<std::unique_ptr<ECE_UringWorker>> workers;
+    std::vector<std::thread> threads;
+};
+
+#endif //LAB5_ECE_URINGREACTOR_H
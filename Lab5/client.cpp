@@ -1,10 +1,12 @@
 /*
  * Author: Shuojiang Liu
  * Class: ECE6122
- * Last Date Modified: Nov 21, 2023
+ * Last Date Modified: Oct 18, 2026
  * Description:
  * This is the client side of the program.
  * This program does not use SFML, instead, it uses Linux socket programming library.
+ * Messages are sent in the compact version 103 frames by default, "v 102" switches to the
+ * fixed 1004-byte messages of the original protocol.
  * Compile with: g++ client.cpp -std=c++17 -lpthread -o client
  * (Make sure to add -std=c++17 and -lpthread flags on PACE!)
  * Run with: ./client <IP Address> <Port Number>
@@ -17,25 +19,21 @@
 #include <string>
 #include <thread>
 #include <unistd.h>
-
-// The data being sent back and forth
-struct tcpMessage
-{
-    unsigned char nVersion;
-    unsigned char nType;
-    unsigned short nMsgLen;
-    char chMsg[1000];
-};
+#include <vector>
+#include "ECE_ChatProtocol.h"
 
 std::mutex lastMessageMutex;
 
 // Use another thread to receive messages from the server
 void receiveMessage(int clientSocket)
 {
-    tcpMessage message;
+    // frames may arrive split or merged, bytes are collected until a whole frame is there
+    std::vector<char> input;
+    char buffer[4096];
+    ChatMessage message;
     while (true)
     {
-        int bytesReceived = recv(clientSocket, &message, sizeof(message), 0);
+        int bytesReceived = recv(clientSocket, buffer, sizeof(buffer), 0);
         if (bytesReceived < 0)
         {
             std::cerr << "Error receiving message" << std::endl;
@@ -48,12 +46,24 @@ void receiveMessage(int clientSocket)
             lastMessageMutex.unlock();
             break;
         }
-        else
+
+        input.insert(input.end(), buffer, buffer + bytesReceived);
+        std::size_t consumed = 0, frameSize = 0;
+        FrameStatus status;
+        while ((status = decodeFrame(input.data() + consumed, input.size() - consumed, message, frameSize)) ==
+               FrameStatus::Complete)
         {
+            consumed += frameSize;
             lastMessageMutex.lock();
-            std::cout << "Received Msg Type: " << (int)message.nType << "; Msg: " << message.chMsg << std::endl;
+            std::cout << "Received Msg Type: " << (int)message.nType << "; Msg: " << message.text.c_str() << std::endl;
             lastMessageMutex.unlock();
         }
+        input.erase(input.begin(), input.begin() + consumed);
+        if (status == FrameStatus::Invalid)
+        {
+            std::cerr << "Invalid message from server" << std::endl;
+            break;
+        }
     }
 }
 
@@ -104,8 +114,8 @@ int main(int argc, char *argv[])
     std::thread receiveThread(receiveMessage, clientSocket);
 
     std::string command;
-    tcpMessage message;
-    message.nVersion = 102;
+    ChatMessage message;
+    message.nVersion = COMPACT_VERSION;
     while (true)
     {
         std::cout << "Please enter command: ";
@@ -123,9 +133,14 @@ int main(int argc, char *argv[])
         {
             // The command is: t [number] [message string]
             message.nType = atoi(command.substr(2, command.find(' ', 2) - 2).c_str());
-            strcpy(message.chMsg, command.substr(command.find(' ', 2) + 1).c_str());
-            message.nMsgLen = strlen(message.chMsg);
-            send(clientSocket, &message, sizeof(message), 0);
+            message.text = command.substr(command.find(' ', 2) + 1);
+            if (message.nVersion != COMPACT_VERSION)
+            {
+                // the old messages hold at most 999 characters and a terminating null
+                message.text.resize(std::min<std::size_t>(message.text.size(), sizeof(tcpMessage::chMsg) - 1));
+            }
+            std::string frame = encodeMessage(message, message.nVersion);
+            send(clientSocket, frame.data(), frame.size(), 0);
         }
         else
         {
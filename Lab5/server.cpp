@@ -1,41 +1,31 @@
 /*
  * Author: Shuojiang Liu
  * Class: ECE6122
- * Last Date Modified: Nov 21, 2023
+ * Last Date Modified: Oct 18, 2026
  * Description:
  * This is the server side of the program.
  * This program does not use SFML, instead, it uses Linux socket programming library.
- * Compile with: g++ server.cpp -std=c++17 -lpthread -o server
+ * Connections are served by a small fixed set of worker threads, each running an edge-triggered
+ * epoll loop over non-blocking sockets with its own SO_REUSEPORT listener. With -transport uring
+ * the workers drive io_uring instead, on kernels without it the server falls back to epoll.
+ * Compile with: g++ server.cpp ECE_ChatServer.cpp ECE_EpollReactor.cpp ECE_UringReactor.cpp -std=c++17 -lpthread -o server
  * (Make sure to add -std=c++17 and -lpthread flags on PACE!)
- * Run with: ./server
+ * Run with: ./server [-workers <count>] [-transport epoll|uring] [-high-watermark <bytes>] [-low-watermark <bytes>]
+ *                   [-slow-policy drop-oldest|drop-newest|disconnect]
  */
 
 #include <algorithm>
-#include <arpa/inet.h>
-#include <cstring>
+#include <cstdlib>
 #include <iostream>
-#include <mutex>
-#include <netinet/in.h>
+#include <memory>
 #include <string>
+#include <sys/resource.h>
 #include <thread>
-#include <unistd.h>
-#include <vector>
+#include "ECE_ChatServer.h"
+#include "ECE_EpollReactor.h"
+#include "ECE_UringReactor.h"
 
-const int MAX_CLIENT = 100;
-
-// The data being sent back and forth
-struct tcpMessage
-{
-    unsigned char nVersion;
-    unsigned char nType;
-    unsigned short nMsgLen;
-    char chMsg[1000];
-};
-
-std::vector<int> clientSockets;
-std::mutex clientListMutex, lastMessageMutex;
-tcpMessage lastMessage;
-bool isLastMessageAvailable = false;
+ECE_ChatServer chatServer;
 
 // The program continuously prompt the user for commands to execute
 void handleUserInput()
@@ -45,46 +35,34 @@ void handleUserInput()
     while (true)
     {
         std::cout << "Please enter command: ";
-        std::getline(std::cin, command);
+        if (!std::getline(std::cin, command))
+        {
+            // no terminal attached, keep serving without the prompt
+            return;
+        }
 
         if (command == "msg")
         {
             // Print the last message received
-            lastMessageMutex.lock();
-            if (isLastMessageAvailable)
+            ChatMessage lastMessage;
+            if (chatServer.getLastMessage(lastMessage))
             {
-                std::cout << "Last Message: " << lastMessage.chMsg << std::endl;
+                std::cout << "Last Message: " << lastMessage.text << std::endl;
             }
             else
             {
                 std::cout << "No message received yet." << std::endl;
             }
-            lastMessageMutex.unlock();
         }
         else if (command == "clients")
         {
             // Print all connected clients
-            clientListMutex.lock();
-            std::cout << "Number of Clients: " << clientSockets.size() << std::endl;
-            for (int client : clientSockets)
-            {
-                struct sockaddr_in clientAddr;
-                socklen_t clientAddrLen = sizeof(clientAddr);
-                getpeername(client, (struct sockaddr *)&clientAddr, &clientAddrLen);
-                std::cout << "IP Address: " << inet_ntoa(clientAddr.sin_addr)
-                          << " | Port: " << ntohs(clientAddr.sin_port) << std::endl;
-            }
-            clientListMutex.unlock();
+            chatServer.printClients(std::cout);
         }
         else if (command == "exit")
         {
             // Close all sockets and terminate the program
-            clientListMutex.lock();
-            for (int client : clientSockets)
-            {
-                close(client);
-            }
-            clientListMutex.unlock();
+            chatServer.closeAll();
             exit(EXIT_SUCCESS);
         }
         else
@@ -94,123 +72,102 @@ void handleUserInput()
     }
 }
 
-// Handle the client connection
-void handleClient(int clientSocket)
+// Raises the open file limit to the hard limit, each connection needs a descriptor
+void raiseDescriptorLimit()
 {
-    tcpMessage message;
-    while (true)
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
     {
-        memset(&message, 0, sizeof(message));
-        int readSize = read(clientSocket, &message, sizeof(message));
-        if (readSize == 0)
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned workerCount = std::max(1u, std::thread::hardware_concurrency());
+    std::string transport = "epoll";
+    ECE_OutputLimits limits;
+    bool lowWatermarkSet = false;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::string option = argv[arg];
+        std::string value = arg + 1 < argc ? argv[arg + 1] : "";
+        if (option == "-workers" && std::atoi(value.c_str()) > 0)
         {
-            std::cout << "Client " << clientSocket << " disconnected" << std::endl;
-            break;
+            workerCount = std::atoi(argv[++arg]);
         }
-        else if (readSize < 0)
+        else if (option == "-high-watermark" && std::atoll(value.c_str()) > 0)
         {
-            std::cerr << "read error" << std::endl;
-            break;
+            limits.highWatermark = std::atoll(argv[++arg]);
         }
-
-        // update the last message
-        lastMessageMutex.lock();
-        lastMessage = message;
-        isLastMessageAvailable = true;
-        lastMessageMutex.unlock();
-
-        if (message.nVersion != 102)
+        else if (option == "-low-watermark" && std::atoll(value.c_str()) >= 0 && !value.empty())
         {
-            std::cout << "Invalid version, message ignored" << std::endl;
-            continue;
+            limits.lowWatermark = std::atoll(argv[++arg]);
+            lowWatermarkSet = true;
         }
-
-        if (message.nType == 77)
+        else if (option == "-slow-policy" && (value == "drop-oldest" || value == "drop-newest" || value == "disconnect"))
         {
-            std::cout << "Broadcasting message: " << message.chMsg << std::endl;
-            clientListMutex.lock();
-            for (int client : clientSockets)
-            {
-                if (client != clientSocket)
-                {
-                    write(client, &message, sizeof(message));
-                }
-            }
-            clientListMutex.unlock();
+            limits.policy = value == "drop-oldest" ? SlowConsumerPolicy::DropOldest :
+                            value == "drop-newest" ? SlowConsumerPolicy::DropNewest : SlowConsumerPolicy::Disconnect;
+            arg++;
         }
-        else if (message.nType == 201)
+        else if (option == "-transport" && (value == "epoll" || value == "uring"))
         {
-            std::cout << "Reversing message: " << message.chMsg << std::endl;
-            std::reverse(message.chMsg, message.chMsg + message.nMsgLen);
-            write(clientSocket, &message, sizeof(message));
+            transport = argv[++arg];
         }
         else
         {
-            std::cout << "Invalid type" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [-workers <count>] [-transport epoll|uring]"
+                      << " [-high-watermark <bytes>] [-low-watermark <bytes>]"
+                      << " [-slow-policy drop-oldest|drop-newest|disconnect]" << std::endl;
+            exit(EXIT_FAILURE);
         }
     }
-    close(clientSocket);
-    clientListMutex.lock();
-    // Remove the client from the list
-    clientSockets.erase(std::remove(clientSockets.begin(), clientSockets.end(), clientSocket), clientSockets.end());
-    clientListMutex.unlock();
-}
-
-int main()
-{
-    struct sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(9999);
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-
-    int serverFd;
-
-    if (serverFd = socket(AF_INET, SOCK_STREAM, 0); serverFd < 0)
+    if (!lowWatermarkSet)
     {
-        std::cerr << "socket error" << std::endl;
-        exit(EXIT_FAILURE);
+        limits.lowWatermark = limits.highWatermark / 2;
     }
-
-    if (bind(serverFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
+    if (limits.lowWatermark > limits.highWatermark)
     {
-        std::cerr << "bind error" << std::endl;
+        std::cerr << "The low watermark must not be above the high watermark" << std::endl;
         exit(EXIT_FAILURE);
     }
+    chatServer.setOutputLimits(limits);
 
-    if (listen(serverFd, MAX_CLIENT) < 0)
+    raiseDescriptorLimit();
+
+    std::unique_ptr<ECE_Reactor> reactor;
+    std::string error;
+    if (transport == "uring")
     {
-        std::cerr << "listen error" << std::endl;
-        exit(EXIT_FAILURE);
+        reactor = std::make_unique<ECE_UringReactor>(chatServer, SERVER_PORT, workerCount);
+        if (!reactor->start(error))
+        {
+            // releases the listeners opened so far before epoll binds its own
+            reactor.reset();
+            std::cerr << "io_uring unavailable (" << error << "), falling back to epoll" << std::endl;
+            transport = "epoll";
+        }
     }
-
-    std::cout << "Server is listening on " << inet_ntoa(serverAddr.sin_addr) << ":" << ntohs(serverAddr.sin_port)
-              << std::endl;
-
-    int clientSocket;
-    struct sockaddr_in clientAddr;
-    socklen_t clientAddrLen = sizeof(clientAddr);
-
-    // Create a thread for command handling
-    std::thread userInputThread(handleUserInput);
-
-    while (true)
+    if (transport == "epoll")
     {
-        if (clientSocket = accept(serverFd, (struct sockaddr *)&clientAddr, &clientAddrLen); clientSocket < 0)
+        reactor = std::make_unique<ECE_EpollReactor>(chatServer, SERVER_PORT, workerCount);
+        if (!reactor->start(error))
         {
-            std::cerr << "accept error" << std::endl;
-            break;
+            std::cerr << error << std::endl;
+            exit(EXIT_FAILURE);
         }
-        std::cout << "New connection from " << inet_ntoa(clientAddr.sin_addr) << ":" << ntohs(clientAddr.sin_port)
-                  << std::endl;
-        clientListMutex.lock();
-        clientSockets.push_back(clientSocket);
-        clientListMutex.unlock();
-        std::thread clientThread(handleClient, clientSocket);
-        clientThread.detach();
     }
 
+    std::cout << "Server is listening on 0.0.0.0:" << SERVER_PORT << " with " << workerCount << " " << transport
+              << " worker" << (workerCount == 1 ? "" : "s") << std::endl;
+
+    // Create a thread for command handling
+    std::thread userInputThread(handleUserInput);
+
+    reactor->join();
     userInputThread.join();
-    close(serverFd);
 
     return 0;
 }